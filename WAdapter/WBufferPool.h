@@ -0,0 +1,74 @@
+#ifndef W_BUFFER_POOL_H
+#define W_BUFFER_POOL_H
+
+#include "Arduino.h"
+#include <new>
+
+/*
+ * Fixed number of equal blocks in one allocation, made at boot before the
+ * heap gets fragmented. checkout() returns nullptr if all blocks are in use.
+ */
+class WBufferPool {
+public:
+	WBufferPool(size_t blockSize, unsigned int count) {
+		// free blocks hold the pointer to the next free one
+		this->blockSize = ((max(blockSize, sizeof(void*)) + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*);
+		this->count = count;
+		this->blocks = new (std::nothrow) uint8_t[this->blockSize * count];
+		this->freeBlocks = 0;
+		this->firstFree = nullptr;
+		if (this->blocks == nullptr) {
+			this->count = 0;
+		} else {
+			for (unsigned int i = count; i > 0; i--) {
+				checkin(this->blocks + (i - 1) * this->blockSize);
+			}
+		}
+	}
+
+	~WBufferPool() {
+		if (this->blocks) {
+			delete[] this->blocks;
+		}
+	}
+
+	void* checkout() {
+		void* block = this->firstFree;
+		if (block != nullptr) {
+			this->firstFree = *((void**) block);
+			this->freeBlocks--;
+		}
+		return block;
+	}
+
+	void checkin(void* block) {
+		*((void**) block) = this->firstFree;
+		this->firstFree = block;
+		this->freeBlocks++;
+	}
+
+	bool contains(void* block) {
+		return ((block >= this->blocks) && (block < this->blocks + this->blockSize * this->count));
+	}
+
+	size_t getBlockSize() {
+		return this->blockSize;
+	}
+
+	unsigned int getFreeBlocks() {
+		return this->freeBlocks;
+	}
+
+	unsigned int getCount() {
+		return this->count;
+	}
+
+private:
+	uint8_t* blocks;
+	size_t blockSize;
+	unsigned int count;
+	unsigned int freeBlocks;
+	void* firstFree;
+};
+
+#endif
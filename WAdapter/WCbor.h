@@ -0,0 +1,430 @@
+#ifndef _WCBOR_H__
+#define _WCBOR_H__
+
+#include "Arduino.h"
+#include "WJson.h"
+
+const static uint8_t CBOR_UNSIGNED = 0x00;
+const static uint8_t CBOR_NEGATIVE = 0x20;
+const static uint8_t CBOR_BYTES = 0x40;
+const static uint8_t CBOR_TEXT = 0x60;
+const static uint8_t CBOR_ARRAY = 0x80;
+const static uint8_t CBOR_MAP = 0xA0;
+const static uint8_t CBOR_TAG = 0xC0;
+const static uint8_t CBOR_SIMPLE = 0xE0;
+const static uint8_t CBOR_FALSE = 0xF4;
+const static uint8_t CBOR_TRUE = 0xF5;
+const static uint8_t CBOR_NULL = 0xF6;
+const static uint8_t CBOR_HALF = 0xF9;
+const static uint8_t CBOR_FLOAT = 0xFA;
+const static uint8_t CBOR_DOUBLE = 0xFB;
+const static uint8_t CBOR_INDEFINITE = 0x1F;
+const static uint8_t CBOR_BREAK = 0xFF;
+
+/*
+ * CBOR (RFC 8949) writer with the calls of WJson, so values can be written
+ * in either encoding. Objects and arrays have indefinite length, there are
+ * no separators to track. Output is buffered like in WJson. Doubles are written as half or single precision
+ * floats if that keeps the digits WJson would print.
+ */
+class WCbor {
+public:
+	WCbor(Print* stream) {
+		this->stream = stream;
+	}
+
+	/* Counting mode: nothing is written, length() tells how long the output would be */
+	WCbor() {
+		this->stream = &counter;
+	}
+
+	~WCbor() {
+		flush();
+	}
+
+	/* Writes buffered output to the stream. Done automatically when the outermost object or array is closed. */
+	WCbor& flush() {
+		if (bufferPos > 0) {
+			written += stream->write(buffer, bufferPos);
+			bufferPos = 0;
+		}
+		return *this;
+	}
+
+	/* Number of bytes of output so far */
+	size_t length() {
+		return written + bufferPos;
+	}
+
+	WCbor& beginObject() {
+		return beginObject("");
+	}
+
+	WCbor& beginObject(const char* name) {
+		if (name && strlen(name)) {
+			memberName(name);
+		}
+		write(CBOR_MAP | CBOR_INDEFINITE);
+		depth++;
+		return *this;
+	}
+
+	WCbor& memberName(const char *name) {
+		if (name != nullptr) {
+			string(name);
+		}
+		return *this;
+	}
+
+	WCbor& endObject() {
+		write(CBOR_BREAK);
+		closed();
+		return *this;
+	}
+
+	WCbor& beginArray() {
+		write(CBOR_ARRAY | CBOR_INDEFINITE);
+		depth++;
+		return *this;
+	}
+
+	WCbor& beginArray(const char* name) {
+		memberName(name);
+		return beginArray();
+	}
+
+	WCbor& endArray() {
+		write(CBOR_BREAK);
+		closed();
+		return *this;
+	}
+
+	WCbor& propertyString(const char* name, const char *value) {
+		memberName(name);
+		return string(value);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2) {
+		memberName(name);
+		return string(value1, value2);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3) {
+		memberName(name);
+		return string(value1, value2, value3);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4) {
+		memberName(name);
+		return string(value1, value2, value3, value4);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5, const char *value6) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5, value6);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5, const char *value6, const char *value7) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5, value6, value7);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5, const char *value6, const char *value7, const char *value8) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5, value6, value7, value8);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5, const char *value6, const char *value7, const char *value8, const char *value9) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5, value6, value7, value8, value9);
+	}
+
+	WCbor& propertyString(const char* name, const char *value1, const char *value2, const char *value3, const char *value4, const char *value5, const char *value6, const char *value7, const char *value8, const char *value9, const char *value10) {
+		memberName(name);
+		return string(value1, value2, value3, value4, value5, value6, value7, value8, value9, value10);
+	}
+
+	WCbor& propertyInteger(const char* name, int value) {
+		memberName(name);
+		return numberInteger(value);
+	}
+
+	WCbor& propertyLong(const char* name, long value) {
+		memberName(name);
+		return numberLong(value);
+	}
+
+	WCbor& propertyUnsignedLong(const char* name, unsigned long value) {
+		memberName(name);
+		return numberUnsignedLong(value);
+	}
+
+	WCbor& propertyByte(const char* name, byte value) {
+		memberName(name);
+		return numberByte(value);
+	}
+
+	WCbor& propertyDouble(const char* name, double value) {
+		memberName(name);
+		return numberDouble(value);
+	}
+
+	WCbor& propertyDouble(const char* name, double value, unsigned int digits) {
+		memberName(name);
+		return numberDouble(value, digits);
+	}
+
+	WCbor& propertyBoolean(const char* name, bool value) {
+		memberName(name);
+		return boolean(value);
+	}
+
+	WCbor& string(const char *text) {
+		size_t size = (text != nullptr ? strlen(text) : 0);
+		writeHead(CBOR_TEXT, size);
+		if (size > 0) write((const uint8_t*) text, size);
+		return *this;
+	}
+
+	WCbor& string(const char *text1, const char *text2) {
+		return string(text1, text2, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3) {
+		return string(text1, text2, text3, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4) {
+		return string(text1, text2, text3, text4, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5) {
+		return string(text1, text2, text3, text4, text5, nullptr, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6) {
+		return string(text1, text2, text3, text4, text5, text6, nullptr, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6, const char *text7) {
+		return string(text1, text2, text3, text4, text5, text6, text7, nullptr, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6, const char *text7, const char *text8) {
+		return string(text1, text2, text3, text4, text5, text6, text7, text8, nullptr, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6, const char *text7, const char *text8, const char *text9) {
+		return string(text1, text2, text3, text4, text5, text6, text7, text8, text9, nullptr);
+	}
+
+	WCbor& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6, const char *text7, const char *text8, const char *text9, const char *text10) {
+		const char* texts[] = { text1, text2, text3, text4, text5, text6, text7, text8, text9, text10 };
+		size_t total = 0;
+		for (const char* text : texts) {
+			if (text != nullptr) total += strlen(text);
+		}
+		writeHead(CBOR_TEXT, total);
+		for (const char* text : texts) {
+			if (text != nullptr) write((const uint8_t*) text, strlen(text));
+		}
+		return *this;
+	}
+
+	WCbor& numberInteger(int number) {
+		return numberLong(number);
+	}
+
+	WCbor& numberLong(long number) {
+		if (number < 0) {
+			// -1 - n, without overflow for LONG_MIN
+			writeHead(CBOR_NEGATIVE, (unsigned long) (-(number + 1)));
+		} else {
+			writeHead(CBOR_UNSIGNED, (unsigned long) number);
+		}
+		return *this;
+	}
+
+	WCbor& numberUnsignedLong(unsigned long number) {
+		writeHead(CBOR_UNSIGNED, number);
+		return *this;
+	}
+
+	WCbor& numberByte(byte number) {
+		writeHead(CBOR_UNSIGNED, number);
+		return *this;
+	}
+
+	WCbor& numberDouble(double number) {
+		return numberDouble(number, 2);
+	}
+
+	WCbor& numberDouble(double number, unsigned int digits) {
+		writeDouble(number, digits);
+		return *this;
+	}
+
+	WCbor& null() {
+		write(CBOR_NULL);
+		return *this;
+	}
+
+	WCbor& boolean(bool value) {
+		write(value ? CBOR_TRUE : CBOR_FALSE);
+		return *this;
+	}
+
+private:
+	Print* stream;
+	uint8_t buffer[WJSON_BUFFER_SIZE];
+	unsigned int bufferPos = 0;
+	size_t written = 0;
+	WCountingPrint counter;
+	int depth = 0;
+
+	void write(uint8_t b) {
+		if (bufferPos == WJSON_BUFFER_SIZE) {
+			flush();
+		}
+		buffer[bufferPos++] = b;
+	}
+
+	void write(const uint8_t* data, size_t length) {
+		if (length > WJSON_BUFFER_SIZE - bufferPos) {
+			flush();
+			if (length >= WJSON_BUFFER_SIZE) {
+				written += stream->write(data, length);
+				return;
+			}
+		}
+		memcpy(&buffer[bufferPos], data, length);
+		bufferPos += length;
+	}
+
+	void closed() {
+		depth--;
+		if (depth <= 0) {
+			depth = 0;
+			flush();
+		}
+	}
+
+	// initial byte and argument in the shortest form
+	void writeHead(uint8_t major, uint64_t value) {
+		uint8_t head[9];
+		unsigned int size;
+		if (value < 24) {
+			head[0] = major | (uint8_t) value;
+			size = 1;
+		} else if (value <= 0xFF) {
+			head[0] = major | 24;
+			size = 2;
+		} else if (value <= 0xFFFF) {
+			head[0] = major | 25;
+			size = 3;
+		} else if (value <= 0xFFFFFFFFUL) {
+			head[0] = major | 26;
+			size = 5;
+		} else {
+			head[0] = major | 27;
+			size = 9;
+		}
+		for (unsigned int i = size - 1; i > 0; i--) {
+			head[i] = (uint8_t) value;
+			value >>= 8;
+		}
+		write(head, size);
+	}
+
+	void writeDouble(double number, unsigned int digits) {
+		// the value WJson would print, so both encodings carry the same number
+		double scale = decimalScale(digits);
+		if (fabs(number) * scale < 1e15) {
+			number = nearbyint(number * scale) / scale;
+		}
+		uint16_t half;
+		double halfValue;
+		float single = (float) number;
+		if ((toHalf(number, &half, &halfValue)) && ((halfValue == number) || (isnan(number)) || (sameDigits(number, halfValue, digits)))) {
+			uint8_t bytes[] = { CBOR_HALF, (uint8_t) (half >> 8), (uint8_t) half };
+			write(bytes, sizeof(bytes));
+		} else if (((double) single == number) || (sameDigits(number, single, digits))) {
+			uint8_t bytes[5];
+			uint32_t bits;
+			memcpy(&bits, &single, sizeof(bits));
+			bytes[0] = CBOR_FLOAT;
+			for (int i = 4; i > 0; i--) {
+				bytes[i] = (uint8_t) bits;
+				bits >>= 8;
+			}
+			write(bytes, sizeof(bytes));
+		} else {
+			uint8_t bytes[9];
+			uint64_t bits;
+			memcpy(&bits, &number, sizeof(bits));
+			bytes[0] = CBOR_DOUBLE;
+			for (int i = 8; i > 0; i--) {
+				bytes[i] = (uint8_t) bits;
+				bits >>= 8;
+			}
+			write(bytes, sizeof(bytes));
+		}
+	}
+
+	static double decimalScale(unsigned int digits) {
+		static const double scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+		return (digits < 7 ? scales[digits] : pow(10, digits));
+	}
+
+	// true if both round to the same number with this many decimals
+	bool sameDigits(double number, double other, unsigned int digits) {
+		double scale = decimalScale(digits);
+		if (!(fabs(number) * scale < 1e15)) {
+			return false;
+		}
+		return (llround(number * scale) == llround(other * scale));
+	}
+
+	// nearest half precision float, false if out of its normal range
+	bool toHalf(double value, uint16_t* half, double* halfValue) {
+		*halfValue = value;
+		if (isnan(value)) {
+			*half = 0x7E00;
+			return true;
+		}
+		float single = (float) value;
+		uint32_t bits;
+		memcpy(&bits, &single, sizeof(bits));
+		uint16_t sign = (bits >> 16) & 0x8000;
+		if (isinf(value)) {
+			*half = sign | 0x7C00;
+			return true;
+		} else if (value == 0) {
+			*half = sign;
+			return true;
+		}
+		int exponent = (int) ((bits >> 23) & 0xFF) - 127;
+		// 23 bits of mantissa rounded to 10
+		uint32_t mantissa = ((bits & 0x7FFFFF) + 0x1000) >> 13;
+		if (mantissa == 0x400) {
+			mantissa = 0;
+			exponent++;
+		}
+		if ((exponent < -14) || (exponent > 15)) {
+			return false;
+		}
+		*half = sign | ((exponent + 15) << 10) | mantissa;
+		bits = (bits & 0x80000000) | ((uint32_t) (exponent + 127) << 23) | (mantissa << 13);
+		memcpy(&single, &bits, sizeof(single));
+		*halfValue = single;
+		return true;
+	}
+
+};
+
+#endif
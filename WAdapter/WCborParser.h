@@ -0,0 +1,278 @@
+#ifndef _WCBOR_PARSER_H__
+#define _WCBOR_PARSER_H__
+
+#include "Arduino.h"
+#include "WCbor.h"
+#include "WJsonParser.h"
+
+#define CBOR_MAX_NESTING 8
+
+/*
+ * Reads the top level map of a CBOR payload and hands each key with its
+ * value as text to the same key/value handling as WJsonParser: properties
+ * of a device are set with parse(), or kvFunction is called. Nested maps,
+ * arrays, byte strings and null values are skipped.
+ */
+class WCborParser: public WJsonParser {
+public:
+	WProperty* parse(const uint8_t* payload, size_t length, WDevice *device) {
+		reset();
+		this->device = device;
+		return parseMap(payload, length);
+	}
+
+	void parse(const uint8_t* payload, size_t length, TProcessKeyValueFunction kvFunction) {
+		reset();
+		this->kvFunction = kvFunction;
+		parseMap(payload, length);
+	}
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+	char key[BUFFER_MAX_LENGTH];
+	char value[BUFFER_MAX_LENGTH];
+
+	WProperty* parseMap(const uint8_t* payload, size_t length) {
+		this->data = payload;
+		this->size = length;
+		this->pos = 0;
+		WProperty* result = nullptr;
+		uint8_t major;
+		uint64_t count;
+		bool indefinite;
+		if ((!readHead(&major, &count, &indefinite)) || (major != CBOR_MAP)) {
+			return result;
+		}
+		for (uint64_t i = 0; (indefinite) || (i < count); i++) {
+			if ((indefinite) && (pos < size) && (data[pos] == CBOR_BREAK)) {
+				break;
+			}
+			int hasKey = readScalar(key);
+			int hasValue = (hasKey >= 0 ? readScalar(value) : -1);
+			if (hasValue < 0) {
+				// truncated or malformed
+				break;
+			} else if ((hasKey > 0) && (hasValue > 0)) {
+				WProperty* p = processKeyValue(key, value);
+				if (p != nullptr) {
+					result = p;
+				}
+			}
+		}
+		return result;
+	}
+
+	bool readHead(uint8_t* major, uint64_t* argument, bool* indefinite) {
+		if (pos >= size) {
+			return false;
+		}
+		uint8_t initial = data[pos++];
+		uint8_t info = initial & 0x1F;
+		*major = initial & 0xE0;
+		*indefinite = false;
+		*argument = 0;
+		if (info < 24) {
+			*argument = info;
+		} else if (info <= 27) {
+			size_t n = 1 << (info - 24);
+			if (n > size - pos) {
+				return false;
+			}
+			for (size_t i = 0; i < n; i++) {
+				*argument = (*argument << 8) | data[pos++];
+			}
+		} else if (info == CBOR_INDEFINITE) {
+			*indefinite = true;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	/* Writes a number, text or boolean as text to out: 1 if written, 0 if skipped, -1 on error */
+	int readScalar(char* out) {
+		uint8_t major;
+		uint64_t argument;
+		bool indefinite;
+		size_t start;
+		do {
+			start = pos;
+			if (!readHead(&major, &argument, &indefinite)) {
+				return -1;
+			}
+		} while (major == CBOR_TAG);
+		switch (major) {
+		case CBOR_UNSIGNED:
+			formatUnsigned(out, argument);
+			return 1;
+		case CBOR_NEGATIVE:
+			// -1 - argument; -2^64 doesn't fit into any property and is skipped
+			if (argument == UINT64_MAX) {
+				return 0;
+			}
+			out[0] = '-';
+			formatUnsigned(out + 1, argument + 1);
+			return 1;
+		case CBOR_TEXT:
+			return (readString(out, argument, indefinite) ? 1 : -1);
+		case CBOR_SIMPLE: {
+			uint8_t info = data[start] & 0x1F;
+			if (info == 20) {
+				strcpy(out, JSON_FALSE);
+				return 1;
+			} else if (info == 21) {
+				strcpy(out, JSON_TRUE);
+				return 1;
+			} else if (info == 25) {
+				return formatDouble(out, halfToDouble((uint16_t) argument), 4);
+			} else if (info == 26) {
+				float single;
+				uint32_t bits = (uint32_t) argument;
+				memcpy(&single, &bits, sizeof(single));
+				return formatDouble(out, single, 7);
+			} else if (info == 27) {
+				double number;
+				memcpy(&number, &argument, sizeof(number));
+				return formatDouble(out, number, 15);
+			}
+			return (indefinite ? -1 : 0);
+		}
+		default:
+			return (skipContent(major, argument, indefinite, 0) ? 0 : -1);
+		}
+	}
+
+	// text string, definite or in chunks; cut like in WJsonParser if too long
+	bool readString(char* out, uint64_t length, bool indefinite) {
+		size_t outPos = 0;
+		while (true) {
+			if (indefinite) {
+				if (pos >= size) {
+					return false;
+				} else if (data[pos] == CBOR_BREAK) {
+					pos++;
+					break;
+				}
+				uint8_t major;
+				bool chunkIndefinite;
+				if ((!readHead(&major, &length, &chunkIndefinite)) || (major != CBOR_TEXT) || (chunkIndefinite)) {
+					return false;
+				}
+			}
+			if (length > size - pos) {
+				return false;
+			}
+			size_t n = min((size_t) length, (size_t) (BUFFER_MAX_LENGTH - 1 - outPos));
+			memcpy(out + outPos, data + pos, n);
+			outPos += n;
+			pos += length;
+			if (!indefinite) {
+				break;
+			}
+		}
+		out[outPos] = '\0';
+		return true;
+	}
+
+	bool skipItem(int depth) {
+		uint8_t major;
+		uint64_t argument;
+		bool indefinite;
+		if (!readHead(&major, &argument, &indefinite)) {
+			return false;
+		}
+		return skipContent(major, argument, indefinite, depth);
+	}
+
+	bool skipContent(uint8_t major, uint64_t argument, bool indefinite, int depth) {
+		if (depth > CBOR_MAX_NESTING) {
+			return false;
+		}
+		switch (major) {
+		case CBOR_BYTES:
+		case CBOR_TEXT:
+			if (indefinite) {
+				break;
+			}
+			if (argument > size - pos) {
+				return false;
+			}
+			pos += argument;
+			return true;
+		case CBOR_MAP:
+			argument *= 2;
+			break;
+		case CBOR_ARRAY:
+			break;
+		case CBOR_TAG:
+			return skipItem(depth + 1);
+		default:
+			// numbers and simple values have no content
+			return !((indefinite) && (major != CBOR_SIMPLE));
+		}
+		// items of a container or chunks of a string
+		for (uint64_t i = 0; (indefinite) || (i < argument); i++) {
+			if ((indefinite) && (pos < size) && (data[pos] == CBOR_BREAK)) {
+				pos++;
+				return true;
+			}
+			if (!skipItem(depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void formatUnsigned(char* out, uint64_t number) {
+		char digits[20];
+		unsigned int n = 0;
+		do {
+			digits[n++] = '0' + (number % 10);
+			number /= 10;
+		} while (number > 0);
+		while (n > 0) {
+			*out++ = digits[--n];
+		}
+		*out = '\0';
+	}
+
+	// with the significant digits of the float type but at least the 2 decimals WCbor keeps, without trailing zeros
+	int formatDouble(char* out, double number, int significant) {
+		if (!(fabs(number) < 1e15)) {
+			// nan, inf and numbers no property can take
+			return 0;
+		}
+		int decimals = significant - 1 - (number == 0 ? 0 : (int) floor(log10(fabs(number))));
+		decimals = max(2, min(15, decimals));
+		dtostrf(number, 1, decimals, out);
+		if (strchr(out, '.') != nullptr) {
+			size_t length = strlen(out);
+			while (out[length - 1] == '0') {
+				out[--length] = '\0';
+			}
+			if (out[length - 1] == '.') {
+				out[--length] = '\0';
+			}
+		}
+		return 1;
+	}
+
+	double halfToDouble(uint16_t half) {
+		int exponent = (half >> 10) & 0x1F;
+		int mantissa = half & 0x3FF;
+		double number;
+		if (exponent == 0) {
+			number = ldexp(mantissa, -24);
+		} else if (exponent == 31) {
+			number = (mantissa == 0 ? INFINITY : NAN);
+		} else {
+			number = ldexp(mantissa + 1024, exponent - 25);
+		}
+		return ((half & 0x8000) ? -number : number);
+	}
+
+};
+
+#endif
@@ -70,28 +70,31 @@ public:
 		this->blue = strtol(buffer, NULL, 16);
 	}
 
-	bool parse(String value) {
-		if ((!isReadOnly()) && (value != nullptr)) {
-			if ((value.startsWith("#")) && (value.length() == 7)) {
-				setString(value.c_str());
+	using WProperty::parse;
+
+	bool parse(const char* data, size_t length) {
+		if ((!isReadOnly()) && (data != nullptr)) {
+			if ((length == 7) && (data[0] == '#')) {
+				setString(data, length);
 				return true;
-			} else if ((value.startsWith("rgb(")) && (value.endsWith(")"))) {
-				value = value.substring(4, value.length() - 1);
-				int theComma;
+			} else if ((length >= 5) && (strncmp(data, "rgb(", 4) == 0) && (data[length - 1] == ')')) {
+				const char* value = data + 4;
+				const char* end = data + length - 1;
+				const char* theComma;
 				//red
 				byte red = 0;
-				if ((theComma = value.indexOf(",")) > -1) {
-					red = value.substring(0, theComma).toInt();
-					value = value.substring(theComma + 1);
+				if ((theComma = (const char*) memchr(value, ',', end - value)) != nullptr) {
+					red = parseLong(value, theComma - value);
+					value = theComma + 1;
 				}
 				//green
 				byte green = 0;
-				if ((theComma = value.indexOf(",")) > -1) {
-					green = value.substring(0, theComma).toInt();
-					value = value.substring(theComma + 1);
+				if ((theComma = (const char*) memchr(value, ',', end - value)) != nullptr) {
+					green = parseLong(value, theComma - value);
+					value = theComma + 1;
 				}
 				//blue
-				byte blue = value.toInt();
+				byte blue = parseLong(value, end - value);
 				setRGB(red, green, blue);
 			}
 		}
@@ -2,9 +2,12 @@
 #define W_DEVICE_H
 
 #include "WProperty.h"
+#include "WPropertyIndex.h"
+#include "WStringStream.h"
 #include "WLevelProperty.h"
 #include "WOnOffProperty.h"
 #include "WStringProperty.h"
+#include "WEnumProperty.h"
 #include "WIntegerProperty.h"
 #include "WLevelIntProperty.h"
 #include "WLongProperty.h"
@@ -54,12 +57,18 @@ public:
 		this->mainDevice = true;
 		this->lastStateNotify = 0;
 		this->stateNotifyInterval = 300000;
+		this->lastFullStateNotify = 0;
+		this->fullStateNotifyInterval = 3600000;
 		this->mqttRetain = false;
 		this->mqttSendChangedValues = false;
+		this->propertyOwner.notification = [this](WProperty*) {onPropertyChange();};
 	}
 
 	~WDevice() {
 		//if (webSocket) delete webSocket;
+		if (this->jsonStructureCache) {
+			delete this->jsonStructureCache;
+		}
 	}
 
 	const char* getId() {
@@ -80,7 +89,9 @@ public:
 	}
 
 	void addProperty(WProperty* property) {
-		property->setDeviceNotification(std::bind(&WDevice::onPropertyChange, this));
+		property->setOwner(&this->propertyOwner);
+		this->propertyOwner.structureVersion++;
+		this->propertyIndex.add(property);
 		if (lastProperty == nullptr) {
 			firstProperty = property;
 			lastProperty = property;
@@ -111,14 +122,42 @@ public:
 	}
 
 	WProperty* getPropertyById(const char* propertyId) {
+		return this->propertyIndex.get(propertyId);
+	}
+
+	// with the hash of propertyId, if it was computed already
+	WProperty* getPropertyById(const char* propertyId, WPropertyIndex::THash hash) {
+		return this->propertyIndex.get(propertyId, hash);
+	}
+
+	/*
+	 * Between begin and commit, changed properties only record the change.
+	 * On commit each of them calls onChange and its settings notification
+	 * once, and the device is notified once. Transactions can be nested.
+	 */
+	void beginTransaction() {
+		if (this->transactionDepth++ == 0) {
+			WProperty* property = this->firstProperty;
+			while (property != nullptr) {
+				property->beginDeferredNotify();
+				property = property->next;
+			}
+		}
+	}
+
+	void commitTransaction() {
+		if ((this->transactionDepth == 0) || (--this->transactionDepth > 0)) {
+			return;
+		}
+		bool changed = false;
 		WProperty* property = this->firstProperty;
 		while (property != nullptr) {
-			if (strcmp(property->getId(), propertyId) == 0) {
-				return property;
-			}
+			changed = (property->endDeferredNotify() || changed);
 			property = property->next;
 		}
-		return nullptr;
+		if (changed) {
+			onPropertyChange();
+		}
 	}
 
 	virtual void toJsonValues(WJson* json, WPropertyVisibility visibility) {
@@ -131,10 +170,148 @@ public:
 		}
 	}
 
+	virtual void toCborValues(WCbor* cbor, WPropertyVisibility visibility) {
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			if (property->isVisible(visibility)) {
+				property->toCborValue(cbor);
+			}
+			property = property->next;
+		}
+	}
+
+	// only the properties changed since the last state message
+	void toJsonChangedValues(WJson* json, WPropertyVisibility visibility) {
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			if ((property->isVisible(visibility)) && (property->isChangedSince(this->stateSequence))) {
+				property->toJsonValue(json);
+			}
+			property = property->next;
+		}
+	}
+
+	void toCborChangedValues(WCbor* cbor, WPropertyVisibility visibility) {
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			if ((property->isVisible(visibility)) && (property->isChangedSince(this->stateSequence))) {
+				property->toCborValue(cbor);
+			}
+			property = property->next;
+		}
+	}
+
+	// publishes held back changes and heartbeats of properties with a publish interval
+	void loopPublishFilters(unsigned long now) {
+		if (this->propertyOwner.publishFilters == 0) {
+			return;
+		}
+		bool changed = false;
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			changed = (property->loopPublishFilter(now) || changed);
+			property = property->next;
+		}
+		if (changed) {
+			onPropertyChange();
+		}
+	}
+
+	// a property of this device changed after the given change sequence
+	bool isChangedSince(unsigned long sequence) {
+		unsigned long changeSequence = this->propertyOwner.changeSequence;
+		return ((changeSequence != 0) && ((long) (changeSequence - sequence) > 0));
+	}
+
+	bool isStateChanged(WPropertyVisibility visibility) {
+		if (!isChangedSince(this->stateSequence)) {
+			return false;
+		}
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			if ((property->isVisible(visibility)) && (property->isChangedSince(this->stateSequence))) {
+				return true;
+			}
+			property = property->next;
+		}
+		return false;
+	}
+
+	void setStateUnChanged() {
+		this->stateSequence = propertiesChangeSequence;
+	}
+
+	/*
+	 * Single value messages go out one property per call, in the order of
+	 * the list. A round walks the list once and returns the properties
+	 * changed since the start of the previous round, or all of them after
+	 * sendAllMqttValues(). nullptr if there's nothing (more) to send.
+	 */
+	WProperty* nextMqttValue(WPropertyVisibility visibility) {
+		if (this->mqttValuesNext == nullptr) {
+			if ((!this->mqttValuesAll) && (!isChangedSince(this->mqttValuesSequence))) {
+				return nullptr;
+			}
+			this->mqttValuesNext = this->firstProperty;
+			this->mqttValuesRoundStart = propertiesChangeSequence;
+		}
+		WProperty* found = nullptr;
+		while ((found == nullptr) && (this->mqttValuesNext != nullptr)) {
+			WProperty* property = this->mqttValuesNext;
+			this->mqttValuesNext = property->next;
+			if ((property->isVisible(visibility)) && (!property->isNull())
+					&& ((this->mqttValuesAll) || (property->isChangedSince(this->mqttValuesSequence)))) {
+				found = property;
+			}
+		}
+		if (this->mqttValuesNext == nullptr) {
+			// round done; changes after its start may have been behind the cursor,
+			// isChangedSince(mqttValuesRoundStart) starts the next round for them
+			this->mqttValuesSequence = this->mqttValuesRoundStart;
+			this->mqttValuesAll = false;
+		}
+		return found;
+	}
+
+	void sendAllMqttValues() {
+		this->mqttValuesAll = true;
+		this->mqttValuesNext = nullptr;
+	}
+
+	// property was just sent on its own; it isn't sent again if it's the next one
+	void skipMqttValue(WProperty* property) {
+		if (this->mqttValuesNext == property) {
+			this->mqttValuesNext = property->next;
+		} else if ((this->mqttValuesNext == nullptr) && (!this->mqttValuesAll)) {
+			WProperty* other = this->firstProperty;
+			while (other != nullptr) {
+				if ((other != property) && (other->isChangedSince(this->mqttValuesSequence))) {
+					return;
+				}
+				other = other->next;
+			}
+			// the only change of this device, no round for it
+			this->mqttValuesSequence = this->propertyOwner.changeSequence;
+		}
+	}
+
 	virtual void toJsonStructure(WJson* json, const char* deviceHRef, WPropertyVisibility visibility) {
+		toJsonStructureBegin(json);
+		String href((String)deviceHRef+URI_SEP+this->getId());
+		WProperty* property = this->firstProperty;
+		while (property != nullptr) {
+			if (property->isVisible(visibility)) {
+				property->toJsonStructure(json, property->getId(), href.c_str());
+			}
+			property = property->next;
+		}
+		toJsonStructureEnd(json);
+	}
+
+	// toJsonStructure up to the members of "properties"; WStructureGenerator writes the parts separately
+	virtual void toJsonStructureBegin(WJson* json) {
 		json->beginObject();
 		json->propertyString(STR_NAME, this->getFullName());
-		String href((String)deviceHRef+URI_SEP+this->getId());
 		json->propertyString(STR_CONTEXT, STR_IOTDOTMOZILLA);
 		json->propertyString(STR_TITLE,  this->getFullName());
 		//type
@@ -143,13 +320,9 @@ public:
 		json->endArray();
 		//properties
 		json->beginObject(STR_PROPERTIES);
-		WProperty* property = this->firstProperty;
-		while (property != nullptr) {
-			if (property->isVisible(visibility)) {
-				property->toJsonStructure(json, property->getId(), href.c_str());
-			}
-			property = property->next;
-		}
+	}
+
+	virtual void toJsonStructureEnd(WJson* json) {
 		json->endObject();
 
 		/*
@@ -164,6 +337,47 @@ public:
 		json->endObject();
 	}
 
+	/*
+	 * Output of toJsonStructure, kept until a property is added or metadata changes.
+	 * deviceHRef is compared by pointer, so pass a constant. Returns nullptr if
+	 * there's no heap block for it.
+	 */
+	WStringStream* getJsonStructure(const char* deviceHRef, WPropertyVisibility visibility) {
+		if ((this->jsonStructureCache == nullptr)
+				|| (this->jsonStructureVersion != getStructureVersion())
+				|| (this->jsonStructureHRef != deviceHRef)
+				|| (this->jsonStructureVisibility != visibility)) {
+			if (this->jsonStructureCache) {
+				delete this->jsonStructureCache;
+				this->jsonStructureCache = nullptr;
+			}
+			WJson counter;
+			toJsonStructure(&counter, deviceHRef, visibility);
+			if (counter.length() + 1024 > ESP.getMaxFreeBlockSize()) {
+				// heap too fragmented, the description has to be written piece by piece
+				return nullptr;
+			}
+			this->jsonStructureCache = new WStringStream(counter.length());
+			WJson json(this->jsonStructureCache);
+			toJsonStructure(&json, deviceHRef, visibility);
+			json.flush();
+			this->jsonStructureVersion = getStructureVersion();
+			this->jsonStructureHRef = deviceHRef;
+			this->jsonStructureVisibility = visibility;
+		}
+		return this->jsonStructureCache;
+	}
+
+	// devices which override toJsonStructure with changing output call this on changes
+	void invalidateJsonStructure() {
+		this->propertyOwner.structureVersion++;
+	}
+
+	// changes when a property is added or its metadata changes
+	unsigned long getStructureVersion() {
+		return this->propertyOwner.structureVersion;
+	}
+
     virtual void loop(unsigned long now) {
     	if (statusLed != nullptr) {
     		statusLed->loop(now);
@@ -267,6 +481,13 @@ public:
 	bool isMqttSendChangedValues(){
 		return this->mqttSendChangedValues;
 	}
+	// with delta state messages, all properties are sent at the first notify after this interval; 0 never
+	void setFullStateNotifyInterval(unsigned long fullStateNotifyInterval){
+		this->fullStateNotifyInterval = fullStateNotifyInterval;
+	}
+	unsigned long getFullStateNotifyInterval(){
+		return this->fullStateNotifyInterval;
+	}
 
 	virtual bool hasInfoPage() {
 		return false;
@@ -291,6 +512,10 @@ public:
     WPin* lastPin = nullptr;
     unsigned long lastStateNotify;
     unsigned int stateNotifyInterval;
+    // with delta state messages, all properties are sent after connect (when this is 0) and after the full state interval
+    unsigned long lastFullStateNotify;
+    // change sequence up to which properties were sent in state messages
+    unsigned long stateSequence = 0;
 protected:
     WNetwork* network;
     WLed* statusLed = nullptr;
@@ -306,6 +531,20 @@ private:
 	const char* name;
 	char* fullname;
 	const char* type;
+	WPropertyIndex propertyIndex;
+	unsigned int transactionDepth = 0;
+	unsigned long fullStateNotifyInterval;
+	// shared by all properties of this device
+	WPropertyOwner propertyOwner;
+	WStringStream* jsonStructureCache = nullptr;
+	unsigned long jsonStructureVersion = 0;
+	const char* jsonStructureHRef = nullptr;
+	WPropertyVisibility jsonStructureVisibility = ALL;
+	// round of single value messages, see nextMqttValue()
+	unsigned long mqttValuesSequence = 0;
+	unsigned long mqttValuesRoundStart = 0;
+	WProperty* mqttValuesNext = nullptr;
+	bool mqttValuesAll = false;
 
 	void onPropertyChange() {
 		this->lastStateNotify = 0;
@@ -0,0 +1,118 @@
+#ifndef W_ENUM_PROPERTY_H
+#define W_ENUM_PROPERTY_H
+
+#include "WProperty.h"
+
+/*
+ * String property which can only take one of the values of a constant
+ * table, e.g.
+ *   const char* const MODES[] PROGMEM = {"off", "heat", "cool"};
+ * The entries have to be literals or char arrays; const char* variables
+ * would make the table need a constructor which writes to flash at boot.
+ * It keeps the index into the table instead of a copy of the string, and
+ * its enum list is written from the table. Other values are rejected.
+ */
+class WEnumProperty: public WProperty {
+public:
+	WEnumProperty(const char* id, const char* title, const char* const* values, byte count)
+	: WProperty(id, title, STRING, 0) {
+		this->values = values;
+		this->count = count;
+		this->index = 0;
+	}
+
+	byte getCount() {
+		return this->count;
+	}
+
+	const char* getValue(byte index) {
+		return (index < this->count ? (const char*) pgm_read_ptr(&this->values[index]) : nullptr);
+	}
+
+	// index of value in the table, or -1
+	int indexOf(const char* value, size_t length) {
+		for (byte i = 0; i < this->count; i++) {
+			const char* v = getValue(i);
+			if ((strncmp(v, value, length) == 0) && (v[length] == '\0')) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	byte getIndex() {
+		requestValue();
+		return this->index;
+	}
+
+	void setIndex(byte index) {
+		if (index >= this->count) {
+			return;
+		}
+		if ((isNull()) || (this->index != index)) {
+			this->index = index;
+			setValueChanged();
+		}
+		afterSet();
+	}
+
+	const char* c_str() {
+		requestValue();
+		return (!isNull() ? getValue(this->index) : "");
+	}
+
+	using WProperty::setString;
+
+	// values not in the table are ignored
+	void setString(const char* newValue, size_t newLength) {
+		int i = (newValue != nullptr ? indexOf(newValue, newLength) : -1);
+		if (i >= 0) {
+			setIndex(i);
+		}
+	}
+
+	using WProperty::parse;
+
+	bool parse(const char* data, size_t length) {
+		if ((!isReadOnly()) && (data != nullptr)) {
+			int i = indexOf(data, length);
+			if (i >= 0) {
+				setIndex(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	using WProperty::toString;
+
+	size_t toString(char* buffer, size_t size) {
+		return copyText(buffer, size, c_str());
+	}
+
+	void toJsonValue(WJson* json, bool onlyValue=false) {
+		json->propertyString((onlyValue ? nullptr : getId()), c_str());
+	}
+
+	void toCborValue(WCbor* cbor, bool onlyValue=false) {
+		cbor->propertyString((onlyValue ? nullptr : getId()), c_str());
+	}
+
+	bool hasEnum() {
+		return true;
+	}
+
+protected:
+	void toJsonEnum(WJson* json) {
+		for (byte i = 0; i < this->count; i++) {
+			json->string(getValue(i));
+		}
+	}
+
+private:
+	const char* const* values;
+	byte count;
+	byte index;
+};
+
+#endif
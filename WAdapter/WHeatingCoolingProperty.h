@@ -1,23 +1,22 @@
 #ifndef W_HEATING_COOLING_PROPERTY_H
 #define W_HEATING_COOLING_PROPERTY_H
 
-#include "WProperty.h"
+#include "WEnumProperty.h"
 
 const char* ATTYPE_HEATINGCOOLING PROGMEM = "HeatingCoolingProperty";
 
-const char* VALUE_OFF PROGMEM = "off";
-const char* VALUE_HEATING PROGMEM = "heating";
-const char* VALUE_COOLING PROGMEM = "cooling";
+// arrays, so the table below holds address constants and needs no initialization at boot
+const static char VALUE_OFF[] PROGMEM = "off";
+const static char VALUE_HEATING[] PROGMEM = "heating";
+const static char VALUE_COOLING[] PROGMEM = "cooling";
+const char* const HEATING_COOLING_VALUES[] PROGMEM = {VALUE_OFF, VALUE_HEATING, VALUE_COOLING};
 
-class WHeatingCoolingProperty: public WProperty {
+class WHeatingCoolingProperty: public WEnumProperty {
 public:
 	WHeatingCoolingProperty(const char* id, const char* title)
-	: WProperty(id, title, STRING) {
+	: WEnumProperty(id, title, HEATING_COOLING_VALUES, 3) {
 		this->atType = ATTYPE_HEATINGCOOLING;
 		this->setReadOnly(true);
-		this->addEnumString(VALUE_OFF);
-		this->addEnumString(VALUE_HEATING);
-		this->addEnumString(VALUE_COOLING);
 	}
 
 
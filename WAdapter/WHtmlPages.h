@@ -144,6 +144,8 @@ const static char HTTP_PAGE_CONFIIGURATION_OPTION_MQTTHASS[] PROGMEM = "Support
 const static char HTTP_PAGE_CONFIIGURATION_OPTION_MQTT[] PROGMEM = "Support MQTT";
 const static char HTTP_PAGE_CONFIIGURATION_OPTION_APFALLBACK[] PROGMEM = "Enable Fallback to AP-Mode if WiFi Connection gets lost";
 const static char HTTP_PAGE_CONFIIGURATION_OPTION_MQTTSINGLEVALUES[] PROGMEM = "Send all properties also in separate MQTT messages";
+const static char HTTP_PAGE_CONFIIGURATION_OPTION_MQTTCBOR[] PROGMEM = "Send state and receive commands as CBOR instead of JSON (not with Autodiscovery for Home Assistant)";
+const static char HTTP_PAGE_CONFIIGURATION_OPTION_MQTTDELTA[] PROGMEM = "Send only changed properties in state messages, all of them after connect and hourly";
 
 const static char HTTP_SAVED[]              PROGMEM = R"=====(
 <div>
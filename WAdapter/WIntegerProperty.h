@@ -1,14 +1,14 @@
 #ifndef W_INTEGER_PROPERTY_H
 #define W_INTEGER_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_INTEGER PROGMEM = "IntegerProperty";
 
-class WIntegerProperty: public WProperty {
+class WIntegerProperty: public WTypedProperty<int> {
 public:
 	WIntegerProperty(const char* id, const char* title)
-	: WProperty(id, title, INTEGER) {
+	: WTypedProperty<int>(id, title) {
 		this->atType = ATTYPE_INTEGER;
 	}
 
@@ -3,6 +3,14 @@
 
 #include "Arduino.h"
 
+// output is collected in this many bytes before it's written to the stream
+#ifndef WJSON_BUFFER_SIZE
+#define WJSON_BUFFER_SIZE 64
+#endif
+
+// sign, 10 digits, point, 6 decimals and terminator
+#define WJSON_DOUBLE_LENGTH 20
+
 const static char BBEGIN = '[';
 const static char BEND = ']';
 const static char COMMA = ',';
@@ -15,12 +23,99 @@ const char* JSON_TRUE PROGMEM = "true";
 const char* JSON_FALSE PROGMEM = "false";
 const char* JSON_NULL PROGMEM = "null";
 
+/* Print that drops the output and only counts its length */
+class WCountingPrint: public Print {
+public:
+	size_t length = 0;
+
+	virtual size_t write(uint8_t) {
+		length++;
+		return 1;
+	}
+
+	virtual size_t write(const uint8_t*, size_t size) {
+		length += size;
+		return size;
+	}
+	using Print::write;
+};
+
 class WJson {
 public:
 	WJson(Print* stream) {
 		this->stream = stream;
 	}
 
+	/* Counting mode: nothing is written, length() tells how long the output would be */
+	WJson() {
+		this->stream = &counter;
+	}
+
+	~WJson() {
+		flush();
+	}
+
+	/* Writes buffered output to the stream. Done automatically when the outermost object or array is closed. */
+	WJson& flush() {
+		if (bufferPos > 0) {
+			written += stream->write((const uint8_t*) buffer, bufferPos);
+			bufferPos = 0;
+		}
+		return *this;
+	}
+
+	/* Number of bytes of output so far */
+	size_t length() {
+		return written + bufferPos;
+	}
+
+	/*
+	 * Writes number with digits decimals to text, as Print::print(double, digits) would, without going
+	 * through printf. text needs WJSON_DOUBLE_LENGTH bytes. Returns the length, 0 for more than 6 digits,
+	 * numbers from 1e9 on, nan and inf.
+	 */
+	static unsigned int formatDouble(char* text, double number, unsigned int digits) {
+		static const unsigned long scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+		double magnitude = fabs(number);
+		if ((digits > 6) || (!(magnitude < 1e9))) {
+			return 0;
+		}
+		double scale = scales[digits];
+		// magnitude * scale is exactly scaled + error; round half to even like printf
+		double scaled = magnitude * scale;
+		double error = fma(magnitude, scale, -scaled);
+		double whole = floor(scaled);
+		double diff = (scaled - whole - 0.5) + error;
+		unsigned long long rounded = (unsigned long long) whole;
+		if ((diff > 0) || ((diff == 0) && (rounded & 1))) {
+			rounded++;
+		}
+		unsigned int length = 0;
+		if (signbit(number)) {
+			text[length++] = '-';
+		}
+		char integer[10];
+		unsigned int pos = sizeof(integer);
+		unsigned long i = (unsigned long) (rounded / scales[digits]);
+		do {
+			integer[--pos] = '0' + (i % 10);
+			i /= 10;
+		} while (i > 0);
+		memcpy(&text[length], &integer[pos], sizeof(integer) - pos);
+		length += sizeof(integer) - pos;
+		if (digits > 0) {
+			unsigned long f = (unsigned long) (rounded % scales[digits]);
+			text[length] = '.';
+			for (int d = digits; d > 0; d--) {
+				text[length + d] = '0' + (f % 10);
+				f /= 10;
+			}
+			length += digits + 1;
+		}
+		text[length] = '\0';
+		return length;
+	}
+
 	WJson& beginObject() {
 		return beginObject("");
 	}
@@ -33,7 +128,8 @@ public:
 		if (name && strlen(name)) {
 			memberName(name);
 		}
-		stream->print(SBEGIN);
+		write(SBEGIN);
+		depth++;
 		firstElement = true;
 		return *this;
 	}
@@ -41,24 +137,25 @@ public:
 	WJson& memberName(const char *name) {
 		if (name != nullptr) {
 			string(name);
-			stream->print(DPOINT);
+			write(DPOINT);
 		}
 		return *this;
 	}
 
 	WJson& separator() {
-		stream->print(COMMA);
+		write(COMMA);
 		return *this;
 
 	}
 
 	WJson& endObject() {
-		stream->print(SEND);
+		write(SEND);
 		if (firstElement){
 			// object with no properties
 			firstElement=false;
 			separatorAlreadyCalled=false;
 		}
+		closed();
 		return *this;
 	}
 
@@ -67,7 +164,8 @@ public:
 			ifSeparator();
 		}
 		firstElement = true;
-		stream->print(BBEGIN);
+		write(BBEGIN);
+		depth++;
 		return *this;
 	}
 
@@ -80,12 +178,14 @@ public:
 		firstElement = true;
 		memberName(name);
 		separatorAlreadyCalled = false;
-		stream->print(BBEGIN);
+		write(BBEGIN);
+		depth++;
 		return *this;
 	}
 
 	WJson& endArray() {
-		stream->print(BEND);
+		write(BEND);
+		closed();
 		return *this;
 	}
 
@@ -171,10 +271,14 @@ public:
 	}
 
 	WJson& propertyDouble(const char* name, double value) {
+		return propertyDouble(name, value, 2);
+	}
+
+	WJson& propertyDouble(const char* name, double value, unsigned int digits) {
 		ifSeparator();
 		separatorAlreadyCalled = true;
 		memberName(name);
-		numberDouble(value);
+		numberDouble(value, digits);
 		separatorAlreadyCalled = false;
 		return *this;
 	}
@@ -227,66 +331,70 @@ public:
 	WJson& string(const char *text1, const char *text2, const char *text3, const char *text4, const char *text5, const char *text6, const char *text7, const char *text8, const char *text9, const char *text10) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(QUOTE);
-		if (text1 != nullptr) stream->print(text1);
-		if (text2 != nullptr) stream->print(text2);
-		if (text3 != nullptr) stream->print(text3);
-		if (text4 != nullptr) stream->print(text4);
-		if (text5 != nullptr) stream->print(text5);
-		if (text6 != nullptr) stream->print(text6);
-		if (text7 != nullptr) stream->print(text7);
-		if (text8 != nullptr) stream->print(text8);
-		if (text9 != nullptr) stream->print(text9);
-		if (text10 != nullptr) stream->print(text10);
-		stream->print(QUOTE);
+		write(QUOTE);
+		if (text1 != nullptr) write(text1);
+		if (text2 != nullptr) write(text2);
+		if (text3 != nullptr) write(text3);
+		if (text4 != nullptr) write(text4);
+		if (text5 != nullptr) write(text5);
+		if (text6 != nullptr) write(text6);
+		if (text7 != nullptr) write(text7);
+		if (text8 != nullptr) write(text8);
+		if (text9 != nullptr) write(text9);
+		if (text10 != nullptr) write(text10);
+		write(QUOTE);
 		return *this;
 	}
 
 	WJson& numberInteger(int number) {
 		if(!separatorAlreadyCalled)
 		ifSeparator();
-		stream->print(number, DEC);
+		writeInteger(number);
 		return *this;
 	}
 
-	WJson& numberLong(unsigned long number) {
+	WJson& numberLong(long number) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(number, DEC);
+		writeInteger(number);
 		return *this;
 	}
 	
 	WJson& numberUnsignedLong(unsigned long number) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(number, DEC);
+		writeUnsigned(number);
 		return *this;
 	}
 
 	WJson& numberByte(byte number) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(number, DEC);
+		writeUnsigned(number);
 		return *this;
 	}
 
 	WJson& numberDouble(double number) {
+		return numberDouble(number, 2);
+	}
+
+	WJson& numberDouble(double number, unsigned int digits) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(number);
+		writeDouble(number, digits);
 		return *this;
 	}
 
 	WJson& null() {
 		ifSeparator();
-		stream->print(JSON_NULL);
+		write(JSON_NULL);
 		return *this;
 	}
 
 	WJson& boolean(bool value) {
 		if (!separatorAlreadyCalled)
 			ifSeparator();
-		stream->print(value ? JSON_TRUE : JSON_FALSE);
+		write(value ? JSON_TRUE : JSON_FALSE);
 		return *this;
 	}
 
@@ -296,6 +404,74 @@ private:
 	Print* stream;
 	bool firstElement = true;
 	bool separatorAlreadyCalled = false;
+	char buffer[WJSON_BUFFER_SIZE];
+	unsigned int bufferPos = 0;
+	size_t written = 0;
+	WCountingPrint counter;
+	int depth = 0;
+
+	void write(char c) {
+		if (bufferPos == WJSON_BUFFER_SIZE) {
+			flush();
+		}
+		buffer[bufferPos++] = c;
+	}
+
+	void write(const char* text) {
+		write(text, strlen(text));
+	}
+
+	void write(const char* text, unsigned int length) {
+		if (length > WJSON_BUFFER_SIZE - bufferPos) {
+			flush();
+			if (length >= WJSON_BUFFER_SIZE) {
+				written += stream->write((const uint8_t*) text, length);
+				return;
+			}
+		}
+		memcpy(&buffer[bufferPos], text, length);
+		bufferPos += length;
+	}
+
+	void writeUnsigned(unsigned long number) {
+		// 10 digits for 32 bit, 20 for 64 bit
+		char digits[sizeof(unsigned long) * 5 / 2];
+		unsigned int pos = sizeof(digits);
+		do {
+			digits[--pos] = '0' + (number % 10);
+			number /= 10;
+		} while (number > 0);
+		write(&digits[pos], sizeof(digits) - pos);
+	}
+
+	void writeInteger(long number) {
+		if (number < 0) {
+			write('-');
+			writeUnsigned(0UL - (unsigned long) number);
+		} else {
+			writeUnsigned(number);
+		}
+	}
+
+	void writeDouble(double number, unsigned int digits) {
+		char text[WJSON_DOUBLE_LENGTH];
+		unsigned int length = formatDouble(text, number, digits);
+		if (length == 0) {
+			// large numbers, nan and inf
+			flush();
+			written += stream->print(number, digits);
+			return;
+		}
+		write(text, length);
+	}
+
+	void closed() {
+		depth--;
+		if (depth <= 0) {
+			depth = 0;
+			flush();
+		}
+	}
 
 	void ifSeparator() {
 		if (firstElement) {
@@ -3,9 +3,11 @@
 
 #include "Arduino.h"
 #include "WJson.h"
+#include "WPropertyIndex.h"
 
 #define STATE_START_DOCUMENT     0
 #define STATE_DONE               -1
+#define STATE_FAILED             -2
 #define STATE_IN_ARRAY           1
 #define STATE_IN_OBJECT          2
 #define STATE_END_KEY            3
@@ -26,6 +28,39 @@
 #define STACK_STRING             3
 
 #define BUFFER_MAX_LENGTH  64
+// objects, arrays and strings open at the same time; a deeper document fails
+#define STACK_MAX_DEPTH    20
+
+/*
+ * Events of WJsonParser::begin(WJsonListener*). Objects and arrays come with
+ * begin and end, so a listener can follow nested paths. Keys and strings are
+ * cut to BUFFER_MAX_LENGTH - 1 characters, numbers come as text.
+ */
+class WJsonListener {
+public:
+	virtual ~WJsonListener() {
+	}
+	virtual void beginObject() {
+	}
+	virtual void endObject() {
+	}
+	virtual void beginArray() {
+	}
+	virtual void endArray() {
+	}
+	virtual void key(const char*, size_t) {
+	}
+	virtual void valueString(const char*, size_t) {
+	}
+	virtual void valueNumber(const char*, size_t) {
+	}
+	virtual void valueBoolean(bool) {
+	}
+	virtual void valueNull() {
+	}
+	virtual void endDocument() {
+	}
+};
 
 class WJsonParser {
 public:
@@ -52,27 +87,81 @@ public:
 	}
 
 	void parse(const char *payload, TProcessKeyValueFunction kvFunction) {
-		this->kvFunction = kvFunction;
-		for (unsigned int i = 0; i < strlen(payload); i++) {
-			parseChar(payload[i]);
-		}
+		parse(payload, strlen(payload), kvFunction);
 	}
 
 	WProperty* parse(const char *payload, WDevice *device) {
+		return parse(payload, strlen(payload), device);
+	}
+
+	void parse(const char *payload, size_t length, TProcessKeyValueFunction kvFunction) {
+		begin(kvFunction);
+		feed(payload, length);
+	}
+
+	WProperty* parse(const char *payload, size_t length, WDevice *device) {
+		begin(device);
+		return feed(payload, length);
+	}
+
+	/*
+	 * Starts a new document, which can be passed in pieces to feed().
+	 * Values are set to the properties of device or handed to kvFunction.
+	 */
+	void begin(WDevice *device) {
+		reset();
 		this->device = device;
-		WProperty* result = nullptr;
-		for (unsigned int i = 0; i < strlen(payload); i++) {
-			WProperty* p = parseChar(payload[i]);
+	}
+
+	void begin(TProcessKeyValueFunction kvFunction) {
+		reset();
+		this->kvFunction = kvFunction;
+	}
+
+	void begin(WJsonListener *listener) {
+		reset();
+		this->listener = listener;
+	}
+
+	// parses the next piece of the document, returns the last property set since begin()
+	WProperty* feed(const char *data, size_t length) {
+		for (size_t i = 0; (i < length) && (state != STATE_FAILED); i++) {
+			WProperty* p = parseChar(data[i]);
 			if (p != nullptr) {
-				result = p;
+				updated = p;
 			}
 		}
-		return result;
+		return updated;
+	}
+
+	bool isDone() {
+		return (state == STATE_DONE);
+	}
+
+	// nested too deep or closed more than was opened; the rest of the document is ignored
+	bool isFailed() {
+		return (state == STATE_FAILED);
+	}
+
+	// drops the document and its target, so the parser can be kept for the next one
+	void reset() {
+		state = STATE_START_DOCUMENT;
+		stackPos = 0;
+		bufferPos = 0;
+		unicodeEscapeBufferPos = 0;
+		unicodeBufferPos = 0;
+		characterCounter = 0;
+		currentKey[0] = '\0';
+		keyProperty = nullptr;
+		updated = nullptr;
+		device = nullptr;
+		kvFunction = nullptr;
+		listener = nullptr;
 	}
 
 private:
 	int state;
-	int stack[20];
+	int stack[STACK_MAX_DEPTH];
 	int stackPos = 0;
 	bool doEmitWhitespace = false;
 	char buffer[BUFFER_MAX_LENGTH];
@@ -84,32 +173,38 @@ private:
 	int characterCounter = 0;
 	int unicodeHighSurrogate = 0;
 	bool logging = false;
-	String currentKey;
-	WDevice *device = nullptr;
-	TProcessKeyValueFunction kvFunction;
+	// key of the current value; for a device, its property is looked up with the hash built while the key was read
+	char currentKey[BUFFER_MAX_LENGTH] = "";
+	WPropertyIndex::THash keyHash = 0;
+	WProperty* keyProperty = nullptr;
+	WProperty* updated = nullptr;
 
-	void log(String message) {
+	void log(const char* message) {
 		if (logging) {
 			Serial.println(message);
 		}
 	}
 
+protected:
+	WDevice *device = nullptr;
+	TProcessKeyValueFunction kvFunction;
+	WJsonListener *listener = nullptr;
+
+	// sets the property of device or calls kvFunction
 	WProperty* processKeyValue(const char* key, const char* value) {
-		WProperty* result = nullptr;
 		if (device != nullptr) {
-			result = device->getPropertyById(key);
-			if (result != nullptr) {
-				if (!result->parse(value)) {
-					result = nullptr;
-				}
-			}
-
+			return setProperty(device->getPropertyById(key), value, strlen(value));
 		} else if (kvFunction) {
 			kvFunction(key, value);
 		}
-		return result;
+		return nullptr;
 	}
 
+	WProperty* setProperty(WProperty* property, const char* value, size_t length) {
+		return (((property != nullptr) && (property->parse(value, length))) ? property : nullptr);
+	}
+
+private:
 	WProperty* parseChar(char c) {
 		WProperty* result = nullptr;
 		if ((c == ' ' || c == '\t' || c == '\n' || c == '\r')
@@ -125,11 +220,10 @@ private:
 				result = endString();
 			} else if (c == '\\') {
 				state = STATE_START_ESCAPE;
-			} else if ((c < 0x1f) || (c == 0x7f)) {
+			} else if (((uint8_t) c < 0x20) || (c == 0x7f)) {
 				//throw new RuntimeException("Unescaped control character encountered: " + c + " at position" + characterCounter);
 			} else {
-				buffer[bufferPos] = c;
-				increaseBufferPointer();
+				addStringChar(c);
 			}
 			break;
 		case STATE_IN_ARRAY:
@@ -264,19 +358,45 @@ private:
 		bufferPos = min(bufferPos + 1, BUFFER_MAX_LENGTH - 1);
 	}
 
+	// characters beyond the buffer are dropped, so the hash matches the cut key
+	void addStringChar(char c) {
+		if (bufferPos < BUFFER_MAX_LENGTH - 1) {
+			buffer[bufferPos] = c;
+			bufferPos++;
+			if (stack[stackPos - 1] == STACK_KEY) {
+				keyHash = WPropertyIndex::hashUpdate(keyHash, c);
+			}
+		}
+	}
+
+	WProperty* processValue(const char* value, size_t length) {
+		if (currentKey[0] == '\0') {
+			return nullptr;
+		} else if (device != nullptr) {
+			return setProperty(keyProperty, value, length);
+		} else if (kvFunction) {
+			kvFunction(currentKey, value);
+		}
+		return nullptr;
+	}
+
 	WProperty* endString() {
 		WProperty* result = nullptr;
-		int popped = stack[stackPos - 1];
-		stackPos--;
+		int popped = pop();
 		if (popped == STACK_KEY) {
 			buffer[bufferPos] = '\0';
-			currentKey = String(buffer);
+			memcpy(currentKey, buffer, bufferPos + 1);
+			keyProperty = (device != nullptr ? device->getPropertyById(currentKey, keyHash) : nullptr);
+			if (listener != nullptr) {
+				listener->key(currentKey, bufferPos);
+			}
 			state = STATE_END_KEY;
 		} else if (popped == STACK_STRING) {
-			if (currentKey != "") {
-				buffer[bufferPos] = '\0';
-				result = processKeyValue(currentKey.c_str(), buffer);
+			buffer[bufferPos] = '\0';
+			if (listener != nullptr) {
+				listener->valueString(buffer, bufferPos);
 			}
+			result = processValue(buffer, bufferPos);
 			//buffer[bufferPos] = '\0';
 			//myListener->value(String(buffer));
 			state = STATE_AFTER_VALUE;
@@ -321,13 +441,17 @@ private:
 	}
 
 	void endArray() {
-		int popped = stack[stackPos - 1];
-		stackPos--;
-		if (popped != STACK_ARRAY) {
+		int popped = pop();
+		if (popped < 0) {
+			return;
+		} else if (popped != STACK_ARRAY) {
 			// throw new ParsingError($this->_line_number, $this->_char_number,
 			// "Unexpected end of array encountered.");
 		}
 		log("jsonParser->endArray()");
+		if (listener != nullptr) {
+			listener->endArray();
+		}
 		state = STATE_AFTER_VALUE;
 		if (stackPos == 0) {
 			endDocument();
@@ -335,19 +459,25 @@ private:
 	}
 
 	void startKey() {
-		stack[stackPos] = STACK_KEY;
-		stackPos++;
+		if (!push(STACK_KEY)) {
+			return;
+		}
+		keyHash = WPropertyIndex::hashBegin();
 		state = STATE_IN_STRING;
 	}
 
 	void endObject() {
-		int popped = stack[stackPos];
-		stackPos--;
-		if (popped != STACK_OBJECT) {
+		int popped = pop();
+		if (popped < 0) {
+			return;
+		} else if (popped != STACK_OBJECT) {
 			// throw new ParsingError($this->_line_number, $this->_char_number,
 			// "Unexpected end of object encountered.");
 		}
 		log("jsonParser->endObject()");
+		if (listener != nullptr) {
+			listener->endObject();
+		}
 		state = STATE_AFTER_VALUE;
 		if (stackPos == 0) {
 			endDocument();
@@ -356,29 +486,21 @@ private:
 
 	void processEscapeCharacters(char c) {
 		if (c == '"') {
-			buffer[bufferPos] = '"';
-			increaseBufferPointer();
+			addStringChar('"');
 		} else if (c == '\\') {
-			buffer[bufferPos] = '\\';
-			increaseBufferPointer();
+			addStringChar('\\');
 		} else if (c == '/') {
-			buffer[bufferPos] = '/';
-			increaseBufferPointer();
+			addStringChar('/');
 		} else if (c == 'b') {
-			buffer[bufferPos] = 0x08;
-			increaseBufferPointer();
+			addStringChar(0x08);
 		} else if (c == 'f') {
-			buffer[bufferPos] = '\f';
-			increaseBufferPointer();
+			addStringChar('\f');
 		} else if (c == 'n') {
-			buffer[bufferPos] = '\n';
-			increaseBufferPointer();
+			addStringChar('\n');
 		} else if (c == 'r') {
-			buffer[bufferPos] = '\r';
-			increaseBufferPointer();
+			addStringChar('\r');
 		} else if (c == 't') {
-			buffer[bufferPos] = '\t';
-			increaseBufferPointer();
+			addStringChar('\t');
 		} else if (c == 'u') {
 			state = STATE_UNICODE;
 		} else {
@@ -472,11 +594,11 @@ private:
 	}
 
 	WProperty* endNumber() {
-		WProperty* result = nullptr;
-		if (currentKey != "") {
-			buffer[bufferPos] = '\0';
-			result = processKeyValue(currentKey.c_str(), buffer);
+		buffer[bufferPos] = '\0';
+		if (listener != nullptr) {
+			listener->valueNumber(buffer, bufferPos);
 		}
+		WProperty* result = processValue(buffer, bufferPos);
 		bufferPos = 0;
 		state = STATE_AFTER_VALUE;
 		return result;
@@ -492,18 +614,20 @@ private:
 	}
 
 	void endDocument() {
-		//myListener->endDocument();
+		if (listener != nullptr) {
+			listener->endDocument();
+		}
 		state = STATE_DONE;
 	}
 
 	WProperty* endTrue() {
-		WProperty* result = false;
-		if (currentKey != "") {
-			buffer[bufferPos] = '\0';
-			//String value = String(buffer);
-			if (strcasecmp(buffer, JSON_TRUE) == 0) {
-				result = processKeyValue(currentKey.c_str(), JSON_TRUE);
+		WProperty* result = nullptr;
+		buffer[bufferPos] = '\0';
+		if (strcasecmp(buffer, JSON_TRUE) == 0) {
+			if (listener != nullptr) {
+				listener->valueBoolean(true);
 			}
+			result = processValue(JSON_TRUE, 4);
 		}
 		bufferPos = 0;
 		state = STATE_AFTER_VALUE;
@@ -511,13 +635,13 @@ private:
 	}
 
 	WProperty* endFalse() {
-		WProperty* result = false;
-		if (currentKey != "") {
-			buffer[bufferPos] = '\0';
-			//String value = String(buffer);
-			if (strcasecmp(buffer, JSON_FALSE) == 0) {
-				result = processKeyValue(currentKey.c_str(), JSON_FALSE);
+		WProperty* result = nullptr;
+		buffer[bufferPos] = '\0';
+		if (strcasecmp(buffer, JSON_FALSE) == 0) {
+			if (listener != nullptr) {
+				listener->valueBoolean(false);
 			}
+			result = processValue(JSON_FALSE, 5);
 		}
 		bufferPos = 0;
 		state = STATE_AFTER_VALUE;
@@ -526,9 +650,10 @@ private:
 
 	void endNull() {
 		buffer[bufferPos] = '\0';
-		String value = String(buffer);
-		if (value.equals(JSON_NULL)) {
-			//myListener->value("null");
+		if (strcmp(buffer, JSON_NULL) == 0) {
+			if (listener != nullptr) {
+				listener->valueNull();
+			}
 		} else {
 			// throw new ParsingError($this->_line_number, $this->_char_number,
 			// "Expected 'true'. Got: ".$true);
@@ -538,25 +663,54 @@ private:
 	}
 
 	void startArray() {
-		//myListener->startArray();
+		if (!push(STACK_ARRAY)) {
+			return;
+		}
+		if (listener != nullptr) {
+			listener->beginArray();
+		}
 		state = STATE_IN_ARRAY;
-		stack[stackPos] = STACK_ARRAY;
-		stackPos++;
 	}
 
 	void startObject() {
-		//myListener->startObject();
+		if (!push(STACK_OBJECT)) {
+			return;
+		}
+		if (listener != nullptr) {
+			listener->beginObject();
+		}
 		state = STATE_IN_OBJECT;
-		stack[stackPos] = STACK_OBJECT;
-		stackPos++;
 	}
 
 	void startString() {
-		stack[stackPos] = STACK_STRING;
-		stackPos++;
+		if (!push(STACK_STRING)) {
+			return;
+		}
 		state = STATE_IN_STRING;
 	}
 
+	// false if nesting is deeper than STACK_MAX_DEPTH, the parse fails then
+	bool push(int within) {
+		if (stackPos >= STACK_MAX_DEPTH) {
+			log("jsonParser: nested too deep");
+			state = STATE_FAILED;
+			return false;
+		}
+		stack[stackPos] = within;
+		stackPos++;
+		return true;
+	}
+
+	// -1 if nothing is open, the parse fails then
+	int pop() {
+		if (stackPos == 0) {
+			state = STATE_FAILED;
+			return -1;
+		}
+		stackPos--;
+		return stack[stackPos];
+	}
+
 	void startNumber(char c) {
 		state = STATE_IN_NUMBER;
 		buffer[bufferPos] = c;
@@ -564,8 +718,7 @@ private:
 	}
 
 	void endUnicodeCharacter(int codepoint) {
-		buffer[bufferPos] = convertCodepointToCharacter(codepoint);
-		increaseBufferPointer();
+		addStringChar(convertCodepointToCharacter(codepoint));
 		unicodeBufferPos = 0;
 		unicodeHighSurrogate = -1;
 		state = STATE_IN_STRING;
@@ -1,14 +1,14 @@
 #ifndef W_LEVEL_INT_PROPERTY_H
 #define W_LEVEL_INT_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_LEVELINT PROGMEM = "LevelIntProperty";
 
-class WLevelIntProperty: public WProperty {
+class WLevelIntProperty: public WTypedProperty<int> {
 public:
 	WLevelIntProperty(const char* id, const char* title, int minimum, int maximum)
-	: WProperty(id, title, INTEGER) {
+	: WTypedProperty<int>(id, title) {
 		this->atType = ATTYPE_LEVEL;
 		this->minimum = minimum;
 		this->maximum = maximum;
@@ -20,6 +20,7 @@ public:
 
 	void setMinimum(int minimum) {
 		this->minimum = minimum;
+		structureChanged();
 	}
 
 	int getMaximum() {
@@ -28,6 +29,7 @@ public:
 
 	void setMaximum(int maximum) {
 		this->maximum = maximum;
+		structureChanged();
 	}
 
 	void toJsonStructureAdditionalParameters(WJson* json) {
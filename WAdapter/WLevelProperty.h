@@ -1,14 +1,14 @@
 #ifndef W_LEVEL_PROPERTY_H
 #define W_LEVEL_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_LEVEL PROGMEM = "LevelProperty";
 
-class WLevelProperty: public WProperty {
+class WLevelProperty: public WTypedProperty<double> {
 public:
 	WLevelProperty(const char* id, const char* title, double minimum, double maximum)
-	: WProperty(id, title, DOUBLE) {
+	: WTypedProperty<double>(id, title) {
 		this->atType = ATTYPE_LEVEL;
 		this->minimum = minimum;
 		this->maximum = maximum;
@@ -20,6 +20,7 @@ public:
 
 	void setMinimum(double minimum) {
 		this->minimum = minimum;
+		structureChanged();
 	}
 
 	double getMaximum() {
@@ -28,11 +29,12 @@ public:
 
 	void setMaximum(double maximum) {
 		this->maximum = maximum;
+		structureChanged();
 	}
 
 	void toJsonStructureAdditionalParameters(WJson* json) {
-		json->propertyDouble(STR_MINIMUM, this->getMinimum());
-		json->propertyDouble(STR_MAXIMUM, this->getMaximum());
+		json->propertyDouble(STR_MINIMUM, this->getMinimum(), getDecimals());
+		json->propertyDouble(STR_MAXIMUM, this->getMaximum(), getDecimals());
 	}
 
 protected:
@@ -17,6 +17,8 @@ typedef void (*printfunction)(Print*);
 #define LOG_LEVEL_VERBOSE 6
 
 #define CR "\n"
+// longer messages are cut and end with "..."
+#define LOG_BUFFER_SIZE 256
 #define LOGGING_VERSION 1_0_3
 
 /**
@@ -141,10 +143,13 @@ public:
 private:
     TCommandHandlerFunction onLogCommand;
 
-	void print(int level, const char *format, va_list args) {
-		char logbuf[256];
-		size_t size = sizeof logbuf;
-		vsnprintf_P(logbuf, size-1, format, args);
+	// the format is read from flash by vsnprintf_P, without a copy
+	void print(int level, PGM_P format, va_list args) {
+		char logbuf[LOG_BUFFER_SIZE];
+		int length = vsnprintf_P(logbuf, sizeof(logbuf), format, args);
+		if (length >= (int) sizeof(logbuf)) {
+			strcpy(logbuf + sizeof(logbuf) - 4, "...");
+		}
 		if (level <=_levelConsole) _logOutput->println(logbuf);
    		if (onLogCommand && level <=_levelNetwork) {
     		onLogCommand(level, logbuf );
@@ -152,20 +157,9 @@ private:
     }
 
 	void print(int level, const __FlashStringHelper *format, va_list args) {
-		char logbuf[256];
-		size_t size = sizeof logbuf;
-		PGM_P p = reinterpret_cast<PGM_P>(format);
-		char c;
-		unsigned int pos=0;
-		for(; pos < size-1 && (c = pgm_read_byte(p++)) != 0; pos++) {
-				logbuf[pos]=c;	
-		}
-		logbuf[pos]=0;
-		print(level, logbuf, args);
+		print(level, reinterpret_cast<PGM_P>(format), args);
 	}
 
-
-
 	int _levelConsole;
 	int _levelNetwork;
 	bool _showLevelConsole;
@@ -1,14 +1,14 @@
 #ifndef W_LONG_PROPERTY_H
 #define W_LONG_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_LONG PROGMEM = "LongProperty";
 
-class WLongProperty: public WProperty {
+class WLongProperty: public WTypedProperty<long> {
 public:
 	WLongProperty(const char* id)
-	: WProperty(id, id, LONG) {
+	: WTypedProperty<long>(id, id) {
 		this->atType = ATTYPE_LONG;
 	}
 
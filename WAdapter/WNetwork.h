@@ -4,6 +4,7 @@
 #define SSE_MAX_QUEUED_MESSAGES 4
 
 #include <Arduino.h>
+#include <memory>
 #include <WiFiClient.h>
 #include <ESP8266WiFi.h>
 #include <ESPAsyncTCP.h>
@@ -22,14 +23,26 @@
 #endif
 #include "WStringStream.h"
 #include "WDevice.h"
+#include "WStructureGenerator.h"
+#include "WSegmentedStream.h"
 #include "WLed.h"
 #include "WSettings.h"
 #include "WJsonParser.h"
+#include "WCborParser.h"
 #include "WLog.h"
 #include "webserverHelper.h"
 
 #define SIZE_MQTT_PACKET 1536
 #define SIZE_JSON_PACKET 3096
+// larger PUT bodies are answered with 413 without parsing them
+#ifndef SIZE_PUT_BODY
+#define SIZE_PUT_BODY SIZE_JSON_PACKET
+#endif
+// segments of 256 bytes for /things responses and MQTT state messages, reserved at boot;
+// the default of WNetwork::setBufferPoolSize()
+#ifndef SIZE_BUFFER_POOL
+#define SIZE_BUFFER_POOL 12
+#endif
 #define NO_LED -1
 
 const char* ID_NETWORK PROGMEM = "network";
@@ -88,6 +101,8 @@ const byte NETBITS1_MQTT       = 1;
 const byte NETBITS1_HASS       = 2;
 const byte NETBITS1_APFALLBACK = 4;
 const byte NETBITS1_MQTTSINGLEVALUES = 8;
+const byte NETBITS1_MQTTCBOR  = 16;
+const byte NETBITS1_MQTTDELTA = 32;
 
 const char* PROP_IDX PROGMEM = "idx";
 const char* PROP_SSID PROGMEM = "ssid";
@@ -154,7 +169,9 @@ public:
 		this->firmwareVersion = firmwareVersion;
 		webServer = nullptr;
 		wnetwork=this;
-		this->bodyBuffer = nullptr;
+		this->bodyParser = nullptr;
+		this->mqttJsonParser = nullptr;
+		this->mqttCborParser = nullptr;
 		this->dnsApServer = nullptr;
 		this->debug = debug;
 		this->statusLedPin = statusLedPin;
@@ -336,6 +353,7 @@ true ||
 		WDevice *device = firstDevice;
 		while (device != nullptr) {
 			device->loop(now);
+			device->loopPublishFilters(now);
 #ifndef MINIMAL
 			if ((this->isMqttConnected()) && (this->isSupportingMqtt())
 					&& ((device->lastStateNotify == 0)
@@ -401,6 +419,11 @@ true ||
 		this->onConfigurationFinished = onConfigurationFinished;
 	}
 
+	// segments reserved when the web server starts; with 0 none are reserved and all come from the heap
+	void setBufferPoolSize(unsigned int bufferPoolSize) {
+		this->bufferPoolSize = bufferPoolSize;
+	}
+
 #ifndef MINIMAL
 	bool sendMqttHassAutodiscover(bool removeDiscovery){
 		if (isSupportingMqtt() && isSupportingMqttHASS() && isMqttConnected() && isStation() && onMqttHassAutodiscover){
@@ -436,6 +459,15 @@ true ||
 		wlog->warning(F("publish MQTT mystery... "));
 	}
 
+	bool publishMqtt(const char* topic, WProperty* property, bool retained=false) {
+		if (property->getType() == STRING) {
+			return publishMqtt(topic, property->c_str(), retained);
+		}
+		char value[WPROPERTY_STRING_LENGTH];
+		property->toString(value, sizeof(value));
+		return publishMqtt(topic, value, retained);
+	}
+
 	bool publishMqtt(const char* topic, WStringStream* response, bool retained=false) {
 		return publishMqtt(topic, response->c_str(), retained);
 	}
@@ -460,8 +492,14 @@ true ||
 	// Creates a web server
 	void startWebServer() {
 		wlog->trace(F("Starting Webserver"));
+		if ((this->bufferPool == nullptr) && (this->bufferPoolSize > 0)) {
+			this->bufferPool = new WBufferPool(WSegmentedStream::getSegmentSize(), this->bufferPoolSize);
+		}
 #ifndef MINIMAL
 		if (this->isSupportingMqtt()) {
+			if (this->responseStream == nullptr) {
+				this->responseStream = new WStringStream(SIZE_MQTT_PACKET);
+			}
 			this->mqttClient = new WAdapterMqtt(debug, wifiClient, SIZE_JSON_PACKET);
 			mqttClient->setCallback(std::bind(&WNetwork::mqttCallback, this,
 										std::placeholders::_1, std::placeholders::_2,
@@ -598,6 +636,14 @@ true ||
 		return this->supportingMqttSingleValues->getBoolean();
 	}
 
+	bool isSupportingMqttCbor() {
+		return this->supportingMqttCbor->getBoolean();
+	}
+
+	bool isSupportingMqttDelta() {
+		return this->supportingMqttDelta->getBoolean();
+	}
+
 	const char* getIdx() {
 		return this->idx->c_str();
 	}
@@ -658,6 +704,16 @@ true ||
 		this->log()->trace(F("Heap Info: MaxFree: %d"), ESP.getMaxFreeBlockSize());
 	}
 
+	// device state messages, written in segments and published piece by piece
+	WSegmentedStream* getMQTTStateStream() {
+		if (stateStream == nullptr) {
+			// a state message is always sent, so segments beyond the pool come from the heap
+			stateStream = new WSegmentedStream(bufferPool, true);
+		}
+		stateStream->flush();
+		return stateStream;
+	}
+
 	WStringStream* getMQTTResponseStream() {
 		if (responseStream == nullptr) {
 			responseStream = new WStringStream(SIZE_MQTT_PACKET);
@@ -713,28 +769,95 @@ true ||
 
 	}
 
-	void handlePutBodyDone(){
-		if (bodyBuffer!=nullptr){
-			delete[] bodyBuffer;
-			bodyBuffer=nullptr;
-		}
-	}
-		
+	// the body is parsed as it arrives, without keeping a copy of it. Its state belongs to the request,
+	// so bodies of concurrent requests don't mix
 	void handlePutBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
-		if (!index){
-			if (bodyBuffer==nullptr){
-				bodyBuffer=new char[total+1];
-				bodyBuffer[0]='\0';
+		PutBody* body = (PutBody*) request->_tempObject;
+		if ((!index) && (body == nullptr)){
+			WDevice* device=getDeviceByPropertiesUri(request->url());
+			if (device==nullptr){
+				return;
 			}
+			body=new PutBody();
+			body->device=device;
+			body->property=nullptr;
+			body->parser=nullptr;
+			body->tooLarge=(total > SIZE_PUT_BODY);
+			if (!body->tooLarge){
+				// the kept parser, unless another body has it
+				body->parser=(bodyParser != nullptr ? bodyParser : new WJsonParser());
+				bodyParser=nullptr;
+				body->parser->begin(device);
+				// one transaction for the whole body, it notifies once when the request is done
+				beginPropertyTransaction(device);
+			}
+			request->_tempObject=body;
+			request->onDisconnect([this, request]() {
+				handlePutBodyDone(request);
+			});
+		}
+		if ((body != nullptr) && (body->parser != nullptr) && (!body->parser->isDone())){
+			body->property=body->parser->feed((const char*) data, len);
 		}
-		memcpy(bodyBuffer+index, data, len);
-		bodyBuffer[index+len]='\0';
-		//bodyBuffer
-		if (index + len == total){
-			//Serial.printf("handlePutBody DONE '%s'\n", bodyBuffer);
+	}
+
+	// after the response or when the client is gone, so the transaction of the body never stays open
+	void handlePutBodyDone(AsyncWebServerRequest *request){
+		PutBody* body = (PutBody*) request->_tempObject;
+		if (body == nullptr){
+			return;
+		}
+		if (body->parser != nullptr){
+			commitPropertyTransaction(body->device);
+			body->parser->reset();
+			if (bodyParser == nullptr){
+				bodyParser=body->parser;
+			} else {
+				delete body->parser;
+			}
 		}
+		delete body;
+		// the server would free() it
+		request->_tempObject=nullptr;
+	}
+
+	// properties set from one message notify once and are saved with one flash commit
+	void beginPropertyTransaction(WDevice* device){
+		device->beginTransaction();
+		settings->beginTransaction();
+	}
+
+	void commitPropertyTransaction(WDevice* device){
+		device->commitTransaction();
+		settings->commitTransaction();
+	}
 
+	// device of a PUT uri which handleOnThings passes to setPropertyValue
+	WDevice* getDeviceByPropertiesUri(const String& uri){
+		if (!uri.startsWith((String)URI_THINGS + (String)URI_SEP)){
+			return nullptr;
+		}
+		String devName=uri.substring(((String)URI_THINGS + (String)URI_SEP).length());
+		// trailing / like in handleOnThings
+		if (devName.endsWith(URI_SEP)){
+			devName.remove(devName.length() - 1);
+		}
+		WDevice *device = this->firstDevice;
+		while (device != nullptr) {
+			if (devName.equals((String)device->getId() + URI_PROPERTIES)){
+				return device;
+			} else if (devName.startsWith((String)device->getId() + URI_PROPERTIES + URI_SEP)){
+				String propName=devName.substring(((String)device->getId() + URI_PROPERTIES + URI_SEP).length());
+				WProperty* property = device->getPropertyById(propName.c_str());
+				if ((property != nullptr) && (property->isVisible(WEBTHING))) {
+					return device;
+				}
+			}
+			device = device->next;
+		}
+		return nullptr;
 	}
+
 	void handleOnThings(AsyncWebServerRequest *request){
 		if (request->method()!=HTTP_GET && request->method()!=HTTP_PUT){
 			request->send(405); // METHOD NOT ALLOWD
@@ -744,7 +867,7 @@ true ||
 
 		String uri = request->url();
 		//strip last /
-		if (uri.substring(uri.length() - 1).c_str()[0]=='/') uri[uri.length() - 1]='\0';
+		if (uri.endsWith(URI_SEP)) uri.remove(uri.length() - 1);
 
 		if (!uri.startsWith(URI_THINGS)){
 			handleUnknown(request); return;
@@ -967,10 +1090,23 @@ private:
 	WProperty *supportingMqttHASS;
 	WProperty *supportingApFallback;
 	WProperty *supportingMqttSingleValues;
+	WProperty *supportingMqttCbor;
+	WProperty *supportingMqttDelta;
 	WProperty *mqttBaseTopic;
 	WProperty *mqttStateTopic;
 	WProperty *mqttSetTopic;
-	char * bodyBuffer;
+	// parsers are kept for the next message
+	WJsonParser* bodyParser;
+	WJsonParser* mqttJsonParser;
+	WCborParser* mqttCborParser;
+	// PUT body of a request, in its _tempObject
+	struct PutBody {
+		WJsonParser* parser;
+		WDevice* device;
+		WProperty* property;
+		// over SIZE_PUT_BODY, not parsed
+		bool tooLarge;
+	};
 #ifndef MINIMAL
 	WAdapterMqtt *mqttClient;
 	long lastMqttConnect;
@@ -980,6 +1116,9 @@ private:
 	WProperty *idx;
 	long lastWifiConnect;
 	WStringStream* responseStream = nullptr;
+	WSegmentedStream* stateStream = nullptr;
+	WBufferPool* bufferPool = nullptr;
+	unsigned int bufferPoolSize = SIZE_BUFFER_POOL;
 	WStringStream* responseStreamWeb = nullptr;
 	AsyncResponseStream *page =nullptr;
 	WLed *statusLed;
@@ -1001,41 +1140,64 @@ private:
 	 * called by WNetwork.h in notify() after wifi/mqtt connect
 	 * and in WNetwork.h loop() after stateNotifyInterval reached (per device)
 	 */
-	void handleDeviceStateChange(WDevice *device) {
+	void handleDeviceStateChange(WDevice *device, bool full = false) {
 		String topic = String(getMqttTopic()) + "/" + MQTT_STAT + "/things/" + String(device->getId()) + "/properties";
 		wlog->notice(F("Device state changed -> send device state... %s"), topic.c_str());
-		mqttSendDeviceState(topic, device);
+		mqttSendDeviceState(topic, device, full);
 	}
 
-	void mqttSendDeviceState(String topic, WDevice *device) {		
+	void mqttSendDeviceState(String topic, WDevice *device, bool full = false) {		
 		if ((this->isMqttConnected()) && (isSupportingMqtt())){
 			if (device->isDeviceStateComplete()) {
+				unsigned long now = millis();
+				// a retained delta would hide the other properties from new subscribers
+				bool delta = ((isSupportingMqttDelta()) && (!device->isMqttRetain()) && (!full)
+						&& (device->lastFullStateNotify != 0)
+						&& ((device->getFullStateNotifyInterval() == 0) || (now - device->lastFullStateNotify < device->getFullStateNotifyInterval())));
+				if ((delta) && (!device->isStateChanged(MQTT))) {
+					device->lastStateNotify = now;
+					return;
+				}
 				wlog->notice(F("Send actual device state via MQTT %s"), topic.c_str());
-				WStringStream* response = getMQTTResponseStream();
-				WJson json(response);
-				json.beginObject();
-				if (device->isMainDevice()) {
-					json.propertyString(PROP_IDX, getIdx());
-					json.propertyString("ip", getDeviceIp().toString().c_str());
-					json.propertyString("firmware", firmwareVersion.c_str());
+				WSegmentedStream* response = getMQTTStateStream();
+				if (isSupportingMqttCbor()) {
+					WCbor cbor(response);
+					cbor.beginObject();
+					if (delta) {
+						device->toCborChangedValues(&cbor, MQTT);
+					} else {
+						deviceStateHeader(&cbor, device);
+						device->toCborValues(&cbor, MQTT);
+					}
+					cbor.endObject();
+				} else {
+					WJson json(response);
+					json.beginObject();
+					if (delta) {
+						device->toJsonChangedValues(&json, MQTT);
+					} else {
+						deviceStateHeader(&json, device);
+						device->toJsonValues(&json, MQTT);
+					}
+					json.endObject();
 				}
-				device->toJsonValues(&json, MQTT);
-				json.endObject();
 								
-				if (mqttClient->publish(topic.c_str(), response->c_str(), device->isMqttRetain())) {
+				if (response->hasError()) {
+					wlog->error(F("No memory for device state of %s"), device->getId());
+				} else if ((mqttClient->beginPublish(topic.c_str(), response->length(), device->isMqttRetain()))
+						&& (response->writeTo(mqttClient) == response->length()) && (mqttClient->endPublish())) {
 					wlog->verbose(F("MQTT sent"));
 				}
-				device->lastStateNotify = millis();
+				response->flush();
+				device->setStateUnChanged();
+				device->lastStateNotify = now;
+				if (!delta) {
+					device->lastFullStateNotify = now;
+				}
 				// send single values
 				if (isSupportingMqttSingleValues() && device->isVisible(MQTT) and device->isMqttSendChangedValues()) {
-					WProperty* property = device->firstProperty;
-					while (property != nullptr) {
-						if (property->isVisible(MQTT) && !property->isNull()) {
-							// we set to Changed, then ne next loop() events the values will be sent out
-							property->setChanged();
-						}
-						property = property->next;
-					}
+					// from the start, then the next loop() events the values will be sent out
+					device->sendAllMqttValues();
 				}
 			} else {
 				wlog->warning(F("Not sending state via MQTT %s, deviceStateComplete=false"), topic.c_str());
@@ -1043,10 +1205,19 @@ private:
 		}
 	}
 
+	template<class W> void deviceStateHeader(W* out, WDevice *device) {
+		if (device->isMainDevice()) {
+			out->propertyString(PROP_IDX, getIdx());
+			out->propertyString("ip", getDeviceIp().toString().c_str());
+			out->propertyString("firmware", firmwareVersion.c_str());
+		}
+	}
+
 	void mqttCallback(char *ptopic, char *payload, unsigned int length) {
 		String ptopicS=String(ptopic);
-		String payloadS=String(payload);
-		wlog->trace(F("Received MQTT callback: '%s'->'%s'"), ptopic, payload, strlen(ptopic), ptopicS.length());
+		// payload isn't terminated and may be CBOR
+		String payloadS=String(payload, length);
+		wlog->trace(F("Received MQTT callback: '%s'->'%s'"), ptopic, payloadS.c_str(), strlen(ptopic), ptopicS.length());
 		if (!ptopicS.startsWith(getMqttTopic())){
 			wlog->notice(F("Ignoring, starts not with our topic '%s'"), getMqttTopic());
 			return;
@@ -1071,13 +1242,21 @@ private:
 								if (length > 0) {
 									//Check, if it's only response to a state before
 									wlog->notice(F("Set several properties for device %s"), device->getId());
-									WJsonParser* parser = new WJsonParser();
-									if (parser->parse(payload, device) == nullptr) {
+									WProperty* updated;
+									beginPropertyTransaction(device);
+									if (isSupportingMqttCbor()) {
+										if (mqttCborParser == nullptr) mqttCborParser = new WCborParser();
+										updated = mqttCborParser->parse((const uint8_t*) payload, length, device);
+									} else {
+										if (mqttJsonParser == nullptr) mqttJsonParser = new WJsonParser();
+										updated = mqttJsonParser->parse(payload, length, device);
+									}
+									commitPropertyTransaction(device);
+									if (updated == nullptr) {
 										wlog->warning(F("No properties updated for device %s"), device->getId());
 									} else {
 										wlog->trace(F("One or more properties updated for device %s"), device->getId());
 									}
-									delete parser;
 								} else {
 									wlog->notice(F("Empty payload for topic 'properties' -> send device state..."));
 									//Empty payload for topic 'properties' ->  just send state (below)
@@ -1091,19 +1270,20 @@ private:
 								if ((property != nullptr) && (property->isVisible(MQTT))) {
 									//Set Property
 									wlog->notice(F("Set property '%s' for device %s"), property->getId(), device->getId(), payloadS.c_str());
-									if (!property->parse(payloadS)) {
+									if (!property->parse(payload, length)) {
 										wlog->warning(F("Property not updated."));
 									} else {
 										wlog->trace(F("Property updated."));
-										// set to unchanged, because we're sending update now immediately
-										property->setUnChanged();
 									}
 									// answer just with changed value
-									publishMqtt((stat_topic+topic).c_str(), property->toString().c_str(), device->isMqttRetain());
+									publishMqtt((stat_topic+topic).c_str(), property, device->isMqttRetain());
+									// not again as single value, if it's the next one to send
+									device->skipMqttValue(property);
 								}
 							}			
 							wlog->notice(F("Sending device State to %sproperties for device %s"), stat_topic.c_str(), device->getName());				
-							mqttSendDeviceState(stat_topic+"properties", device);
+							// an empty command asks for the whole state
+							mqttSendDeviceState(stat_topic+"properties", device, (length == 0));
 						} else {
 							//unknown, ask the device
 							device->handleUnknownMqttCallback(stat_topic, topic, payloadS, length);
@@ -1155,6 +1335,9 @@ private:
 					json.propertyString("topic", ((String)getMqttTopic()+"/"+MQTT_STAT+"/things/"+device->getId()).c_str());
 					json.endObject();
 					mqttClient->publish(topic.c_str(), response->c_str());
+					// whole state in the next loop()
+					device->lastStateNotify = 0;
+					device->lastFullStateNotify = 0;
 					device = device->next;
 				}
 				mqttClient->unsubscribe("devices/#");
@@ -1309,6 +1492,10 @@ private:
 				"", HTTP_PAGE_CONFIIGURATION_OPTION_MQTTHASS);
 			page->printf_P(HTTP_PAGE_CONFIGURATION_OPTION, F("mqsv"), (this->isSupportingMqttSingleValues() ? HTTP_CHECKED : ""),
 				"", HTTP_PAGE_CONFIIGURATION_OPTION_MQTTSINGLEVALUES);
+			page->printf_P(HTTP_PAGE_CONFIGURATION_OPTION, F("mqcb"), (this->isSupportingMqttCbor() ? HTTP_CHECKED : ""),
+				"", HTTP_PAGE_CONFIIGURATION_OPTION_MQTTCBOR);
+			page->printf_P(HTTP_PAGE_CONFIGURATION_OPTION, F("mqdl"), (this->isSupportingMqttDelta() ? HTTP_CHECKED : ""),
+				"", HTTP_PAGE_CONFIIGURATION_OPTION_MQTTDELTA);
 
 			page->printf_P(HTTP_PAGE_CONFIGURATION_MQTT_END);
 			page->printf_P(HTTP_CONFIG_SAVEANDREBOOT_BUTTON);
@@ -1338,6 +1525,8 @@ private:
 			if (getValueOrEmpty(request, "mqhass").equals("true")) nb1 |= NETBITS1_HASS;
 			if (getValueOrEmpty(request, "apfb").equals("true")) nb1 |= NETBITS1_APFALLBACK;
 			if (getValueOrEmpty(request, "mqsv").equals("true")) nb1 |= NETBITS1_MQTTSINGLEVALUES;
+			if ((getValueOrEmpty(request, "mqcb").equals("true")) && (!(nb1 & NETBITS1_HASS))) nb1 |= NETBITS1_MQTTCBOR;
+			if (getValueOrEmpty(request, "mqdl").equals("true")) nb1 |= NETBITS1_MQTTDELTA;
 			settings->setByte(PROP_NETBITS1, nb1);
 			wlog->notice(F("supportingMqtt set to: %d"), nb1);
 			settings->save(); 
@@ -1675,6 +1864,15 @@ private:
 		this->supportingMqttSingleValues->setBoolean(this->netBits1->getByte() & NETBITS1_MQTTSINGLEVALUES);
 		this->supportingMqttSingleValues->setReadOnly(true);
 
+		this->supportingMqttCbor = new WProperty("supportingMqttCbor", "supportingMqttCbor", BOOLEAN);
+		// Home Assistant discovery announces JSON state, so CBOR is off with it
+		this->supportingMqttCbor->setBoolean((this->netBits1->getByte() & NETBITS1_MQTTCBOR) && (!(this->netBits1->getByte() & NETBITS1_HASS)));
+		this->supportingMqttCbor->setReadOnly(true);
+
+		this->supportingMqttDelta = new WProperty("supportingMqttDelta", "supportingMqttDelta", BOOLEAN);
+		this->supportingMqttDelta->setBoolean(this->netBits1->getByte() & NETBITS1_MQTTDELTA);
+		this->supportingMqttDelta->setReadOnly(true);
+
 		settings->addingNetworkSettings = false;
 		bool settingsStored = (settings->existsSettingsNetwork() || (settingsOld && settingsOld->existsSettingsNetwork()));
 		if (settingsStored) {
@@ -1716,20 +1914,16 @@ private:
 		if (!isSupportingMqttSingleValues()) return;
 		WDevice *device = this->firstDevice;
 		while (device != nullptr) {
-			if (device->isVisible(MQTT) and device->isMqttSendChangedValues()) {
-				WProperty* property = device->firstProperty;
-				while (property != nullptr) {
-					if (property->isVisible(MQTT) && property->isChanged() && !property->isNull()) {
-						String stat_topic = String(getMqttTopic()) + String("/") + String(MQTT_STAT) + String("/things/") + String(device->getId()) + String("/properties/") + String(property->getId());
-						//wlog->verbose(F("sending changed property '%s' with value '%s' for device '%s' to topic '%s'"),
-						//	property->getId(), property->toString().c_str(), device->getId(), stat_topic.c_str());
-						publishMqtt(stat_topic.c_str(), property->toString().c_str(), device->isMqttRetain());
-						property->setUnChanged();
-
-						// only one per loop() -> bye
-						return;
-					}
-					property = property->next;
+			if ((device->isVisible(MQTT)) && (device->isMqttSendChangedValues())) {
+				WProperty* property = device->nextMqttValue(MQTT);
+				if (property != nullptr) {
+					String stat_topic = String(getMqttTopic()) + String("/") + String(MQTT_STAT) + String("/things/") + String(device->getId()) + String("/properties/") + String(property->getId());
+					//wlog->verbose(F("sending changed property '%s' with value '%s' for device '%s' to topic '%s'"),
+					//	property->getId(), property->toString().c_str(), device->getId(), stat_topic.c_str());
+					publishMqtt(stat_topic.c_str(), property, device->isMqttRetain());
+
+					// only one per loop() -> bye
+					return;
 				}
 			}
 			device = device->next;
@@ -1739,43 +1933,49 @@ private:
 	
 
 	void getPropertyValue(AsyncWebServerRequest *request, WProperty *property) {
-		WStringStream* responseStreamWeb = new WStringStream(512);
+		WSegmentedStream* responseStreamWeb = new WSegmentedStream(bufferPool, false);
 		WJson json(responseStreamWeb);
 		json.beginObject();
 		property->toJsonValue(&json);
 		json.endObject();
 		property->setRequested(true);
-		//wlog->trace(F("getPropertyValue %s (%d)"), responseStreamWeb->c_str(), ESP.getMaxFreeBlockSize());
-		//request->send_P(200, APPLICATION_JSON, (const uint8_t*)responseStreamWeb->c_str(), strlen(responseStreamWeb->c_str()));
-		request->send(200, APPLICATION_JSON, responseStreamWeb->c_str());
-		//wlog->trace(F("sent %s (%d)"), responseStreamWeb->c_str(), ESP.getMaxFreeBlockSize());
-		delete responseStreamWeb;
+		sendJson(request, responseStreamWeb);
 	}
 
 /* can be tested with:
    curl -H 'Content-Type: application/json' -X PUT -d '{"targetTemperature":24.5}' http://10.10.200.113/things/thermostat/properties/targetTemperature
  */
 	void setPropertyValue(AsyncWebServerRequest *request, WDevice *device) {
-		if (!bodyBuffer){
+		PutBody* body = (PutBody*) request->_tempObject;
+		if ((body != nullptr) && (body->tooLarge)){
+			wlog->warning(F("Sending HTTP Error 413"));
+			request->send(413); // Payload Too Large
+			return;
+		}
+		if ((body == nullptr) || (!body->parser->isDone())){
+			// no body, or it ended before the json did
+			wlog->warning(F("Sending HTTP Error 400"));
+			request->send(400); // Bad Request
+			return;
+		}
+		if (body->device != device){
 			wlog->warning(F("Sending HTTP Error 422"));
 			request->send(422); // Unprocessable Entity
 			return;
 		}
-		WJsonParser parser;
-		WProperty* property = parser.parse(bodyBuffer, device);
+		WProperty* property = body->property;
 		if (property != nullptr) {
 			//response new value
-			wlog->notice(F("Set property value: %s (web request) %s"), property->getId(), bodyBuffer);
-			WStringStream* responseStreamWeb = new WStringStream(512);
+			wlog->notice(F("Set property value: %s (web request)"), property->getId());
+			WSegmentedStream* responseStreamWeb = new WSegmentedStream(bufferPool, false);
 			WJson json(responseStreamWeb);
 			json.beginObject();
 			property->toJsonValue(&json);
 			json.endObject();
-			request->send_P(200, APPLICATION_JSON, responseStreamWeb->c_str());
-			delete responseStreamWeb;	
+			sendJson(request, responseStreamWeb);
 		} else {
 			// unable to parse json
-			wlog->notice(F("unable to parse json: %s"), bodyBuffer);
+			wlog->notice(F("unable to parse json for device %s"), device->getId());
 			request->send(500);
 		}
 	}
@@ -1793,33 +1993,34 @@ private:
 
 	void sendDevicesStructure(AsyncWebServerRequest* request) {
 		wlog->verbose(F("Send description for all devices..."));
-		WStringStream* responseStreamWeb = new WStringStream(3096);
-		WJson json(responseStreamWeb);
-		json.beginArray();
-		WDevice *device = this->firstDevice;
-		while (device != nullptr) {
-			if (device->isVisible(WEBTHING)) {
-				device->toJsonStructure(&json, URI_THINGS, WEBTHING);
-			}
-			device = device->next;
-		}
-		json.endArray();
-		request->send(200, APPLICATION_JSON, responseStreamWeb->c_str());
-		delete responseStreamWeb;
+		sendStructure(request, new WStructureGenerator(this->firstDevice, URI_THINGS, WEBTHING));
 	}
 
 	void sendDeviceStructure(AsyncWebServerRequest *request, WDevice *device) {
 		wlog->verbose(F("Send description for device: %s"), device->getId());
-		WStringStream* responseStreamWeb = new WStringStream(2048);
-		WJson json(responseStreamWeb);
-		device->toJsonStructure(&json, URI_THINGS, WEBTHING);
-		request->send(200, APPLICATION_JSON, responseStreamWeb->c_str());
-		delete responseStreamWeb;
+		sendStructure(request, new WStructureGenerator(device, URI_THINGS, WEBTHING, false));
+	}
+
+	void sendStructure(AsyncWebServerRequest *request, WStructureGenerator* generator) {
+		// chunked, so only one chunk of the description is in memory at a time
+		std::shared_ptr<WStructureGenerator> shared(generator);
+		request->send(request->beginChunkedResponse(APPLICATION_JSON,
+				[this, request, shared](uint8_t *buffer, size_t maxLen, size_t) -> size_t {
+			size_t filled = shared->fill(buffer, maxLen);
+			if (shared->isFailed()) {
+				// a device changed while sending; close(true) here would delete the request under us,
+				// so end the stream and let the connection drop once the filler returned
+				wlog->notice(F("Description changed while sending, abort response"));
+				request->client()->close();
+				return 0;
+			}
+			return filled;
+		}));
 	}
 
 	void sendDeviceValues(AsyncWebServerRequest *request, WDevice *device) {
 		wlog->notice(F("Send all properties for device: %s"), device->getId());
-		WStringStream* responseStreamWeb = new WStringStream(512);
+		WSegmentedStream* responseStreamWeb = new WSegmentedStream(bufferPool, false);
 		WJson json(responseStreamWeb);
 		json.beginObject();
 		if (device->isMainDevice()) {
@@ -1829,8 +2030,22 @@ private:
 		}
 		device->toJsonValues(&json, WEBTHING);
 		json.endObject();
-		request->send(200, APPLICATION_JSON, responseStreamWeb->c_str());
-		delete responseStreamWeb;
+		sendJson(request, responseStreamWeb);
+	}
+
+	// sends and deletes stream; the server copies it piece by piece into its send buffer.
+	// If the pool ran out of segments, the answer is 503
+	void sendJson(AsyncWebServerRequest *request, WSegmentedStream* stream) {
+		if (stream->hasError()) {
+			delete stream;
+			request->send(503); // BUSY
+			return;
+		}
+		std::shared_ptr<WSegmentedStream> shared(stream);
+		request->send(request->beginResponse(APPLICATION_JSON, stream->length(),
+				[shared](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+			return shared->read(buffer, maxLen, index);
+		}));
 	}
 	bool checkAndLogWebAccess(AsyncWebServerRequest *request){
 		if (!request->url().startsWith(URI_THINGS)){
@@ -1838,7 +2053,11 @@ private:
 			wlog->notice(F("Serving: '%s' method %s to %s, maxFree: %d"), request->url().c_str(), request->methodToString(),
 			request->client()->remoteIP().toString().c_str(), ESP.getMaxFreeBlockSize());
 		}
-		if (ESP.getMaxFreeBlockSize()<(5*1024) && !request->url().equals(URI_RESET)){
+		// /things responses are written in small segments and need free heap, but no large block
+		bool busy = (request->url().startsWith(URI_THINGS)
+				? ((ESP.getFreeHeap()<(5*1024)) || (ESP.getMaxFreeBlockSize()<(2*1024)))
+				: (ESP.getMaxFreeBlockSize()<(5*1024)));
+		if (busy && !request->url().equals(URI_RESET)){
 			//wlog->notice(F("Dropping Request with 503 Busy"));
 			request->send(503); // BUSY
 			return false;
@@ -1864,7 +2083,7 @@ static void staticHandleOnPostUploadFirmware(AsyncWebServerRequest *request, Str
 
 static void staticHandleOnPutThings(AsyncWebServerRequest *request){
 	wnetwork->handleOnThings(request);
-	wnetwork->handlePutBodyDone();
+	wnetwork->handlePutBodyDone(request);
 }
 
 static void staticHandleOnPutBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total){
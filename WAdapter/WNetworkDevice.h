@@ -25,7 +25,8 @@ public:
         this->rssi->setVisibility(MQTT);
         this->rssi->setReadOnly(true);
         this->rssi->setMqttSendChangedValues(true);
-        this->rssi->setOnValueRequest([this](WProperty* p) {updateRssi();});
+        // read once per state message, not by every getter
+        this->rssi->setOnValueRequest([this](WProperty* p) {updateRssi();}, 1000);
         this->addProperty(this->rssi);
     
     }
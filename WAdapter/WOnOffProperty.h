@@ -1,14 +1,14 @@
 #ifndef W_ON_OFF_PROPERTY_H
 #define W_ON_OFF_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_ONOFF PROGMEM = "OnOffProperty";
 
-class WOnOffProperty: public WProperty {
+class WOnOffProperty: public WTypedProperty<bool> {
 public:
 	WOnOffProperty(const char* id, const char* title)
-	: WProperty(id, title, BOOLEAN) {
+	: WTypedProperty<bool>(id, title) {
 		this->atType = "";
 	}
 
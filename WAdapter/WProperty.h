@@ -3,8 +3,12 @@
 
 #include <Arduino.h>
 #include "WJson.h"
+#include "WCbor.h"
 
 
+// numbers in toString(), doubles beyond 1e9 are cut
+#define WPROPERTY_STRING_LENGTH 24
+
 const char* STR_MINIMUM PROGMEM = "minimum";
 const char* STR_MAXIMUM PROGMEM = "maximum";
 const char* STR_CELSIUS PROGMEM = "celsius";
@@ -25,6 +29,9 @@ const char* STRPROP_HREF PROGMEM = "href";
 const char* STRPROP_PROPERTIES PROGMEM = "properties";
 const char* STRPROP_URI_SEP PROGMEM = "/";
 
+// bumped whenever a property's value changes, see WProperty::getChangeSequence
+unsigned long propertiesChangeSequence = 0;
+
 enum WPropertyType {
 	BOOLEAN, DOUBLE, INTEGER, LONG, UNSIGNED_LONG, BYTE, STRING
 };
@@ -43,6 +50,45 @@ union WPropertyValue {
 	char* string;
 };
 
+// WPropertyType and the member of WPropertyValue for a C++ type
+template<class T> struct WPropertyTraits;
+
+template<> struct WPropertyTraits<bool> {
+	static const WPropertyType TYPE = BOOLEAN;
+	static bool get(const WPropertyValue& value) { return value.asBoolean; }
+	static void put(WPropertyValue& value, bool v) { value.asBoolean = v; }
+};
+
+template<> struct WPropertyTraits<double> {
+	static const WPropertyType TYPE = DOUBLE;
+	static double get(const WPropertyValue& value) { return value.asDouble; }
+	static void put(WPropertyValue& value, double v) { value.asDouble = v; }
+};
+
+template<> struct WPropertyTraits<int> {
+	static const WPropertyType TYPE = INTEGER;
+	static int get(const WPropertyValue& value) { return value.asInteger; }
+	static void put(WPropertyValue& value, int v) { value.asInteger = v; }
+};
+
+template<> struct WPropertyTraits<long> {
+	static const WPropertyType TYPE = LONG;
+	static long get(const WPropertyValue& value) { return value.asLong; }
+	static void put(WPropertyValue& value, long v) { value.asLong = v; }
+};
+
+template<> struct WPropertyTraits<unsigned long> {
+	static const WPropertyType TYPE = UNSIGNED_LONG;
+	static unsigned long get(const WPropertyValue& value) { return value.asUnsignedLong; }
+	static void put(WPropertyValue& value, unsigned long v) { value.asUnsignedLong = v; }
+};
+
+template<> struct WPropertyTraits<byte> {
+	static const WPropertyType TYPE = BYTE;
+	static byte get(const WPropertyValue& value) { return value.asByte; }
+	static void put(WPropertyValue& value, byte v) { value.asByte = v; }
+};
+
 class WConstStringProperty {
 public:
 	WConstStringProperty(const char * str) {
@@ -60,6 +106,19 @@ public:
 	const char * value;
 };
 
+class WProperty;
+
+/* Shared by the properties of a device: notification of value changes and the version of their metadata */
+struct WPropertyOwner {
+	std::function<void(WProperty* property)> notification;
+	// bumped whenever a property is added or its metadata changes, invalidates the cached description
+	unsigned long structureVersion = 0;
+	// properties with a deadband or publish interval, the device loops only over them if there are any
+	unsigned int publishFilters = 0;
+	// change sequence of the latest change of one of the properties, see WProperty::getChangeSequence
+	unsigned long changeSequence = 0;
+};
+
 class WProperty {
 public:
 	typedef std::function<void(WProperty* property)> TOnPropertyChange;
@@ -81,25 +140,87 @@ public:
 		if (this->atType) {
 			delete this->atType;
 		}
-		if(this->value.string) {
+		if ((this->type == STRING) && (this->value.string)) {
 		    delete[] this->value.string;
 		}
+		if (this->valueRequest) {
+			delete this->valueRequest;
+		}
+		if (this->publishFilter) {
+			delete this->publishFilter;
+		}
+		if (this->ownsOwner) {
+			delete this->owner;
+		}
+		if (this->ownsSettingsNotification) {
+			delete this->settingsNotification;
+		}
 	}
 
-	void setOnValueRequest(TOnPropertyChange onValueRequest) {
-		this->onValueRequest = onValueRequest;
+	/*
+	 * onValueRequest is called by the getters to update the value. With
+	 * maxAge (ms), the value it sets is used that long without calling it
+	 * again, so a sensor is read once per document, not once per getter.
+	 * Rarely used, so only allocated when set.
+	 */
+	void setOnValueRequest(TOnPropertyChange onValueRequest, unsigned long maxAge = 0) {
+		if (this->valueRequest) {
+			delete this->valueRequest;
+			this->valueRequest = nullptr;
+		}
+		if (onValueRequest) {
+			this->valueRequest = new ValueRequest();
+			this->valueRequest->callback = onValueRequest;
+			this->valueRequest->maxAge = maxAge;
+		}
+	}
+
+	// the next getter calls onValueRequest, even within maxAge
+	void invalidateValue() {
+		if (this->valueRequest) {
+			this->valueRequest->requested = false;
+		}
 	}
 
 	void setOnChange(TOnPropertyChange onChange) {
 		this->onChange = onChange;
 	}
 
+	// the same for all properties of a device or settings, so only referenced; the caller keeps it
+	void setOwner(WPropertyOwner* owner) {
+		if (this->ownsOwner) {
+			delete this->owner;
+			this->ownsOwner = false;
+		}
+		this->owner = owner;
+		if ((owner != nullptr) && (this->publishFilter != nullptr)) {
+			owner->publishFilters++;
+		}
+	}
+
+	void setSettingsNotification(TOnPropertyChange* settingsNotification) {
+		if (this->ownsSettingsNotification) {
+			delete this->settingsNotification;
+			this->ownsSettingsNotification = false;
+		}
+		this->settingsNotification = settingsNotification;
+	}
+
+	// former setters taking the callback itself, the property keeps its own copy then
 	void setDeviceNotification(TOnPropertyChange deviceNotification) {
-		this->deviceNotification = deviceNotification;
+		WPropertyOwner* owner = nullptr;
+		if (deviceNotification) {
+			owner = new WPropertyOwner();
+			owner->notification = deviceNotification;
+		}
+		setOwner(owner);
+		this->ownsOwner = (owner != nullptr);
 	}
 
 	void setSettingsNotification(TOnPropertyChange settingsNotification) {
-		this->settingsNotification = settingsNotification;
+		TOnPropertyChange* own = (settingsNotification ? new TOnPropertyChange(settingsNotification) : nullptr);
+		setSettingsNotification(own);
+		this->ownsSettingsNotification = (own != nullptr);
 	}
 
 	const char* getId() {
@@ -121,6 +242,7 @@ public:
 
 	void setType(WPropertyType type) {
 		this->type = type;
+		structureChanged();
 	}
 
 	const char* getAtType() {
@@ -150,47 +272,99 @@ public:
 		this->valueNull = true;
 	}
 
-	bool isChanged() {
-		return (this->changed);
+	/*
+	 * Each published change takes the next number of propertiesChangeSequence.
+	 * Outputs (MQTT state, single values, ...) keep the number they have sent
+	 * up to and ask for the properties changed since, so they don't share a
+	 * flag. 0 for properties which never changed. The counter may wrap, so
+	 * numbers are compared by their difference; that holds while they are
+	 * less than 2^31 changes apart.
+	 */
+	unsigned long getChangeSequence() {
+		return this->changeSequence;
 	}
 
-	void setUnChanged() {
-		this->changed = false;
+	bool isChangedSince(unsigned long sequence) {
+		return ((this->changeSequence != 0) && ((long) (this->changeSequence - sequence) > 0));
 	}
 
+	// to be sent again by all outputs
 	void setChanged() {
-		this->changed = true;
+		if (++propertiesChangeSequence == 0) {
+			// 0 stays for never changed
+			propertiesChangeSequence++;
+		}
+		this->changeSequence = propertiesChangeSequence;
+		if (this->owner != nullptr) {
+			this->owner->changeSequence = propertiesChangeSequence;
+		}
+	}
+
+	/*
+	 * The changed flags shared by all outputs, replaced by the sequence above.
+	 * A flag can't be told apart per output, so these don't compile instead
+	 * of answering for an output they don't know: use isChangedSince().
+	 */
+	bool isChanged() = delete;
+	void setUnChanged() = delete;
+	bool isStateChanged() = delete;
+	void setStateUnChanged() = delete;
+
+	/*
+	 * Was the method to override for own parsing. Final now, so an override
+	 * of it doesn't compile instead of being skipped: override
+	 * parse(const char* data, size_t length), which all overloads end in.
+	 */
+	virtual bool parse(String value) final {
+		return parse(value.c_str(), value.length());
 	}
 
-	virtual bool parse(String value) {
-		if ((!isReadOnly()) && (value != nullptr)) {
+	bool parse(const char* value) {
+		return ((value != nullptr) && (parse(value, strlen(value))));
+	}
+
+	// sets the value from text, which doesn't need to be terminated
+	virtual bool parse(const char* data, size_t length) {
+		if ((!isReadOnly()) && (data != nullptr)) {
 			switch (getType()) {
 				case BOOLEAN: {
-					setBoolean(value.equalsIgnoreCase(STRPROP_TRUE));
+					bool v;
+					parseValue(data, length, v);
+					setBoolean(v);
 					return true;
 				}
 				case DOUBLE: {
-					setDouble(value.toDouble());
+					double v;
+					parseValue(data, length, v);
+					setDouble(v);
 					return true;
 				}
 				case INTEGER: {
-					setInteger(value.toInt());
+					int v;
+					parseValue(data, length, v);
+					setInteger(v);
 					return true;
 				}
 				case LONG: {
-					setLong(value.toInt());
+					long v;
+					parseValue(data, length, v);
+					setLong(v);
 					return true;
 				}
 				case UNSIGNED_LONG: {
-					setUnsignedLong(value.toInt());
+					unsigned long v;
+					parseValue(data, length, v);
+					setUnsignedLong(v);
 					return true;
 				}
 				case BYTE: {
-					setByte(value.toInt());
+					byte v;
+					parseValue(data, length, v);
+					setByte(v);
 					return true;
 				}
 				case STRING: {
-					setString(value.c_str());
+					setString(data, length);
 					return true;
 				}
 			}
@@ -208,13 +382,7 @@ public:
 		if (type != BOOLEAN) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (this->value.asBoolean != newValue));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asBoolean = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	void toggleBoolean() {
@@ -238,17 +406,11 @@ public:
 		if (type != DOUBLE) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (!isEqual(this->value.asDouble, newValue, 0.01)));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asDouble = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	bool equalsDouble(double number) {
-		return ((!this->valueNull) && (isEqual(this->value.asDouble, number, 0.01)));
+		return ((!this->valueNull) && (isEqual(this->value.asDouble, number, getPrecision())));
 	}
 
 	int getInteger() {
@@ -260,13 +422,7 @@ public:
 		if (type != INTEGER) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (this->value.asInteger != newValue));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asInteger = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	long getLong() {
@@ -278,13 +434,7 @@ public:
 		if (type != LONG) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (this->value.asLong != newValue));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asLong = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	unsigned long getUnsignedLong() {
@@ -296,13 +446,7 @@ public:
 		if (type != UNSIGNED_LONG) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (this->value.asUnsignedLong != newValue));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asUnsignedLong = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	bool equalsInteger(int number) {
@@ -314,7 +458,7 @@ public:
 	}
 
 	bool equalsString(const char* toCompare) {
-		return ((!this->valueNull) && (strcmp(this->value.string, toCompare) == 0));
+		return ((!this->valueNull) && (strcmp(c_str(), toCompare) == 0));
 	}
 
 	bool equalsUnsignedLong(unsigned long number) {
@@ -330,20 +474,14 @@ public:
 		if (type != BYTE) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (this->value.asByte != newValue));
-		if (changed) {
-			WPropertyValue valueB;
-			valueB.asByte = newValue;
-			this->setValue(valueB);
-		}
-		afterSet();
+		setTyped(newValue);
 	}
 
 	bool equalsByte(byte number) {
 		return ((!this->valueNull) && (this->value.asByte == number));
 	}
 
-	const char* c_str() {
+	virtual const char* c_str() {
 		requestValue();
 		return value.string;
 	}
@@ -353,26 +491,25 @@ public:
 	}
 
 	void setString(const char* newValue) {
+		setString(newValue, (newValue != nullptr ? strlen(newValue) : 0));
+	}
+
+	virtual void setString(const char* newValue, size_t newLength) {
 		if (type != STRING) {
 			return;
 		}
-		bool changed = ((this->valueNull) || (strcmp(value.string, newValue) != 0));
+		size_t l = min(newLength, (size_t) length);
+		bool changed = ((this->valueNull) || (newValue == nullptr) || (strncmp(value.string, newValue, l) != 0) || (value.string[l] != '\0'));
 		if (changed) {
 			if (newValue != nullptr) {
-				int l = strlen(newValue);
-				if (l > length) {
-					l = length;
-				}
-				strncpy(value.string, newValue, l);
+				memcpy(value.string, newValue, l);
 				value.string[l] = '\0';
 				this->valueNull = false;
 			} else {
 				value.string[0] = '\0';
 				this->valueNull = true;
 			}
-			this->changed = true;
-			valueChanged();
-			notify();
+			afterValueChange();
 		}
 		afterSet();
 	}
@@ -383,6 +520,7 @@ public:
 
 	void setReadOnly(bool readOnly) {
 		this->readOnly = readOnly;
+		structureChanged();
 	}
 
 	const char* getUnit() {
@@ -391,6 +529,7 @@ public:
 
 	void setUnit(const char* unit) {
 		this->unit = unit;
+		structureChanged();
 	}
 
 	double getMultipleOf() {
@@ -399,62 +538,69 @@ public:
 
 	void setMultipleOf(double multipleOf) {
 		this->multipleOf = multipleOf;
+		// 0.5 -> 1 decimal, 1 -> none
+		this->decimals = 2;
+		if (multipleOf > 0.0) {
+			this->decimals = 0;
+			double scaled = multipleOf;
+			while ((this->decimals < 6) && (fabs(scaled - round(scaled)) > scaled * 1e-6)) {
+				this->decimals++;
+				scaled *= 10;
+			}
+		}
+		structureChanged();
+	}
+
+	// decimals of double values in JSON, CBOR and toString(): as many as multipleOf has, 2 without multipleOf
+	unsigned int getDecimals() {
+		return decimals;
 	}
 
 	virtual String toString() {
-		switch (getType()) {
-		case BOOLEAN:
-			return String( (getBoolean() ? STRPROP_TRUE : STRPROP_FALSE));
-			break;
-		case DOUBLE:
-			return String(getDouble());
-			break;
-		case INTEGER:
-			return String(getInteger());
-			break;
-		case LONG:
-			return String(getLong());
-			break;
-		case UNSIGNED_LONG:
-			return String(getUnsignedLong());
-			break;
-		case BYTE:
-			return String(getByte());
-			break;
-		case STRING:
+		if (getType() == STRING) {
 			return String(c_str());
-			break;
 		}
-		return String("");
-
+		char buffer[WPROPERTY_STRING_LENGTH];
+		toString(buffer, sizeof(buffer));
+		return String(buffer);
 	}
 
-	virtual void toJsonValue(WJson* json, bool onlyValue=false) {
-		requestValue();
-		const char* memberName = (onlyValue ? nullptr : getId());
+	/* Value as text into buffer without allocating, strings are cut to size. Returns the length. */
+	virtual size_t toString(char* buffer, size_t size) {
+		char number[WPROPERTY_STRING_LENGTH];
+		const char* text = "";
 		switch (getType()) {
 		case BOOLEAN:
-			json->propertyBoolean(memberName, getBoolean());
+			text = formatValue(number, getBoolean());
 			break;
 		case DOUBLE:
-			json->propertyDouble(memberName, getDouble());
+			text = formatValue(number, getDouble());
 			break;
 		case INTEGER:
-			json->propertyInteger(memberName, getInteger());
+			text = formatValue(number, getInteger());
 			break;
 		case LONG:
-			json->propertyLong(memberName, getLong());
+			text = formatValue(number, getLong());
 			break;
 		case UNSIGNED_LONG:
-			json->propertyUnsignedLong(memberName, getUnsignedLong());
+			text = formatValue(number, getUnsignedLong());
 			break;
 		case BYTE:
-			json->propertyByte(memberName, getByte());
+			text = formatValue(number, getByte());
 			break;
 		case STRING:
-			json->propertyString(memberName, c_str());
+			text = (c_str() != nullptr ? c_str() : "");
 			break;
 		}
+		return copyText(buffer, size, text);
+	}
+
+	virtual void toJsonValue(WJson* json, bool onlyValue=false) {
+		writeValue(json, onlyValue);
+	}
+
+	virtual void toCborValue(WCbor* cbor, bool onlyValue=false) {
+		writeValue(cbor, onlyValue);
 	}
 
 	virtual void toJsonStructure(WJson* json, const char* memberName, const char* deviceHRef) {
@@ -489,22 +635,12 @@ public:
 		}
 		//multipleOf
 		if (this->getMultipleOf() > 0.0) {
-			json->propertyDouble(STRPROP_MULTIPLEOF, this->getMultipleOf());
+			json->propertyDouble(STRPROP_MULTIPLEOF, this->getMultipleOf(), getDecimals());
 		}
 		//enum
 		if (hasEnum()) {
 			json->beginArray(STRPROP_ENUM);
-			WConstStringProperty* propE = this->firstEnum;
-			while (propE != nullptr) {
-				switch (this->getType()) {
-				case STRING:
-					json->string(propE->c_str());
-					break;
-				default:
-					break;
-				}
-				propE = propE->next;
-			}
+			toJsonEnum(json);
 			json->endArray();
 		}
 		//aType
@@ -521,7 +657,7 @@ public:
 		json->endObject();
 	}
 
-	WProperty* next;
+	WProperty* next = nullptr;
 
 	void addEnumString(const char* enumString) {
 		if (type != STRING) {
@@ -541,9 +677,10 @@ public:
 		} else {
 			firstEnum = propEnum;
 		}
+		structureChanged();
 	}
 
-	bool hasEnum() {
+	virtual bool hasEnum() {
 		return (firstEnum != nullptr);
 	}
 
@@ -553,6 +690,7 @@ public:
 
 	void setVisibility(WPropertyVisibility visibility) {
 		this->visibility = visibility;
+		structureChanged();
 	}
 
 	bool isVisible(WPropertyVisibility visibility) {
@@ -561,6 +699,7 @@ public:
 
 	void setAtType(const char* atType) {
 		this->atType = atType;
+		structureChanged();
 	}
 
 	void setMqttSendChangedValues(bool val) {
@@ -574,8 +713,148 @@ public:
 		this->suppressOnChange=val;
 	}
 
+	/*
+	 * Changes of numbers smaller than deadband, or than relative times the
+	 * last published value, are kept but not published: they don't mark the
+	 * property changed for MQTT and don't notify the device. onChange is
+	 * still called.
+	 */
+	void setDeadband(double deadband, double relative = 0.0) {
+		getPublishFilter()->deadband = deadband;
+		this->publishFilter->deadbandRelative = relative;
+	}
+
+	/*
+	 * Publishes changes at most every minInterval ms, later ones are held back
+	 * until the interval is up. With maxInterval, the value is published at
+	 * least that often, even if it didn't change.
+	 */
+	void setPublishInterval(unsigned long minInterval, unsigned long maxInterval = 0) {
+		getPublishFilter()->minInterval = minInterval;
+		this->publishFilter->maxInterval = maxInterval;
+	}
+
+	// called by WNetwork every loop; true if a held back change or heartbeat is due now
+	bool loopPublishFilter(unsigned long now) {
+		if ((this->publishFilter == nullptr) || (this->valueNull)) {
+			return false;
+		}
+		PublishFilter* filter = this->publishFilter;
+		if (((filter->pending) && (now - filter->lastPublish >= filter->minInterval))
+				|| ((filter->maxInterval > 0) && (filter->published) && (now - filter->lastPublish >= filter->maxInterval))) {
+			filter->pending = false;
+			publishedAt(now);
+			setChanged();
+			return true;
+		}
+		return false;
+	}
+
+	/*
+	 * Used by WDevice for transactions: while deferred, changes are only
+	 * recorded. endDeferredNotify calls onChange and settingsNotification
+	 * once and returns true if a change to publish happened in between; the
+	 * device notification is left to the caller.
+	 */
+	void beginDeferredNotify() {
+		this->notifyDeferred = true;
+	}
+
+	bool endDeferredNotify() {
+		this->notifyDeferred = false;
+		if (!this->notifyPending) {
+			return false;
+		}
+		this->notifyPending = false;
+		notifying = true;
+		if ((onChange) && (notifyPendingOnChange)) {
+			onChange(this);
+		}
+		if (settingsNotification) {
+			(*settingsNotification)(this);
+		}
+		notifying = false;
+		this->notifyPendingOnChange = false;
+		bool publish = this->notifyPendingPublish;
+		this->notifyPendingPublish = false;
+		return publish;
+	}
+
 protected:
-	const char* atType;
+	const char* atType = nullptr;
+
+	// like atol, on text which doesn't need to be terminated
+	static long parseLong(const char* data, size_t length) {
+		size_t i = 0;
+		while ((i < length) && ((data[i] == ' ') || (data[i] == '\t'))) {
+			i++;
+		}
+		bool negative = ((i < length) && (data[i] == '-'));
+		if ((i < length) && ((data[i] == '-') || (data[i] == '+'))) {
+			i++;
+		}
+		unsigned long result = 0;
+		while ((i < length) && (data[i] >= '0') && (data[i] <= '9')) {
+			result = result * 10 + (data[i++] - '0');
+		}
+		return (negative ? -(long) result : (long) result);
+	}
+
+	/*
+	 * Like atof. Numbers with up to 15 digits and small exponents, as they come
+	 * from JSON, are exact with one division or multiplication by a power of ten;
+	 * others go to strtod.
+	 */
+	static double parseDouble(const char* data, size_t length) {
+		static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+				1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+		size_t i = 0;
+		while ((i < length) && ((data[i] == ' ') || (data[i] == '\t'))) {
+			i++;
+		}
+		size_t start = i;
+		bool negative = ((i < length) && (data[i] == '-'));
+		if ((i < length) && ((data[i] == '-') || (data[i] == '+'))) {
+			i++;
+		}
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool point = false;
+		for (; i < length; i++) {
+			char c = data[i];
+			if ((c >= '0') && (c <= '9')) {
+				if ((mantissa > 0) || (c > '0')) {
+					digits++;
+				}
+				if (digits <= 15) {
+					mantissa = mantissa * 10 + (c - '0');
+					exponent -= (point ? 1 : 0);
+				} else {
+					exponent += (point ? 0 : 1);
+				}
+			} else if ((c == '.') && (!point)) {
+				point = true;
+			} else {
+				break;
+			}
+		}
+		if ((i < length) && ((data[i] == 'e') || (data[i] == 'E'))) {
+			long e = parseLong(data + i + 1, length - i - 1);
+			exponent += (int) max(-1000L, min(1000L, e));
+		}
+		double result;
+		if ((digits <= 15) && (exponent >= -22) && (exponent <= 22)) {
+			result = (exponent < 0 ? mantissa / POWERS_OF_TEN[-exponent] : mantissa * POWERS_OF_TEN[exponent]);
+		} else {
+			char text[40];
+			size_t n = min(length - start, sizeof(text) - 1);
+			memcpy(text, data + start, n);
+			text[n] = '\0';
+			return strtod(text, nullptr);
+		}
+		return (negative ? -result : result);
+	}
 
 	void initialize(const char* id, const char* title, WPropertyType type, byte length) {
 		this->id = id;
@@ -586,24 +865,38 @@ protected:
 		this->supportingMqtt = true;
 		this->mqttSendChangedValues = false;
 		this->valueNull = true;
-		this->changed = true;
+		this->changeSequence = 0;
 		this->requested = false;
 		this->valueRequesting = false;
 		this->suppressOnChange = false;
 		this->notifying = false;
+		this->notifyDeferred = false;
+		this->notifyPending = false;
+		this->notifyPendingOnChange = false;
+		this->notifyPendingPublish = false;
 		this->readOnly = false;
 		this->atType = nullptr;
 		this->unit = nullptr;
 		this->multipleOf = 0.0;
+		this->decimals = 2;
 		this->onChange = nullptr;
-		this->deviceNotification = nullptr;
+		this->valueRequest = nullptr;
+		this->publishFilter = nullptr;
+		this->owner = nullptr;
 		this->settingsNotification = nullptr;
+		this->ownsOwner = false;
+		this->ownsSettingsNotification = false;
 		this->next = nullptr;
 		switch (type) {
 		case STRING:
 			this->length = length;
-			value.string = new char[length + 1];
-			value.string[0] = '\0';
+			// without length, a subclass keeps the value
+			if (length > 0) {
+				value.string = new char[length + 1];
+				value.string[0] = '\0';
+			} else {
+				value.string = nullptr;
+			}
 			break;
 		case DOUBLE:
 			this->length = sizeof(double);
@@ -624,10 +917,13 @@ protected:
 
 	void setValue(WPropertyValue newValue) {
 		this->value = newValue;
+		setValueChanged();
+	}
+
+	// for subclasses which keep the value themselves
+	void setValueChanged() {
 		this->valueNull = false;
-		this->changed = true;
-		valueChanged();
-		notify();
+		afterValueChange();
 	}
 
 	virtual void valueChanged() {
@@ -637,63 +933,333 @@ protected:
 
 	}
 
+	virtual void toJsonEnum(WJson* json) {
+		WConstStringProperty* propE = this->firstEnum;
+		while (propE != nullptr) {
+			switch (this->getType()) {
+			case STRING:
+				json->string(propE->c_str());
+				break;
+			default:
+				break;
+			}
+			propE = propE->next;
+		}
+	}
+
+	void structureChanged() {
+		if (this->owner) {
+			this->owner->structureVersion++;
+		}
+	}
+
+	// changes of doubles below this are ignored
+	double getPrecision() {
+		return (decimals > 2 ? pow(10, -(int) decimals) : 0.01);
+	}
+
+	// WJson or WCbor
+	template<class W> void writeValue(W* out, bool onlyValue) {
+		requestValue();
+		const char* memberName = (onlyValue ? nullptr : getId());
+		switch (getType()) {
+		case BOOLEAN:
+			putValue(out, memberName, getBoolean());
+			break;
+		case DOUBLE:
+			putValue(out, memberName, getDouble());
+			break;
+		case INTEGER:
+			putValue(out, memberName, getInteger());
+			break;
+		case LONG:
+			putValue(out, memberName, getLong());
+			break;
+		case UNSIGNED_LONG:
+			putValue(out, memberName, getUnsignedLong());
+			break;
+		case BYTE:
+			putValue(out, memberName, getByte());
+			break;
+		case STRING:
+			out->propertyString(memberName, c_str());
+			break;
+		}
+	}
+
+	/*
+	 * Parsing, formatting and writing per value type. The overloads are
+	 * chosen by the compiler, so WTypedProperty needs no switch over the type.
+	 */
+	static void parseValue(const char* data, size_t length, bool& value) {
+		value = ((length == 4) && (strncasecmp(data, STRPROP_TRUE, 4) == 0));
+	}
+
+	static void parseValue(const char* data, size_t length, double& value) {
+		value = parseDouble(data, length);
+	}
+
+	static void parseValue(const char* data, size_t length, int& value) {
+		value = parseLong(data, length);
+	}
+
+	static void parseValue(const char* data, size_t length, long& value) {
+		value = parseLong(data, length);
+	}
+
+	static void parseValue(const char* data, size_t length, unsigned long& value) {
+		value = parseLong(data, length);
+	}
+
+	static void parseValue(const char* data, size_t length, byte& value) {
+		value = parseLong(data, length);
+	}
+
+	// number has WPROPERTY_STRING_LENGTH chars, the result is number or a constant
+	static const char* formatValue(char*, bool value) {
+		return (value ? STRPROP_TRUE : STRPROP_FALSE);
+	}
+
+	const char* formatValue(char* number, double value) {
+		if (WJson::formatDouble(number, value, getDecimals()) == 0) {
+			// large numbers, nan and inf
+			snprintf(number, WPROPERTY_STRING_LENGTH, "%.*f", getDecimals(), value);
+		}
+		return number;
+	}
+
+	static const char* formatValue(char* number, int value) {
+		return itoa(value, number, 10);
+	}
+
+	static const char* formatValue(char* number, long value) {
+		return ltoa(value, number, 10);
+	}
+
+	static const char* formatValue(char* number, unsigned long value) {
+		return ultoa(value, number, 10);
+	}
+
+	static const char* formatValue(char* number, byte value) {
+		return utoa(value, number, 10);
+	}
+
+	template<class W> static void putValue(W* out, const char* memberName, bool value) {
+		out->propertyBoolean(memberName, value);
+	}
+
+	template<class W> void putValue(W* out, const char* memberName, double value) {
+		out->propertyDouble(memberName, value, getDecimals());
+	}
+
+	template<class W> static void putValue(W* out, const char* memberName, int value) {
+		out->propertyInteger(memberName, value);
+	}
+
+	template<class W> static void putValue(W* out, const char* memberName, long value) {
+		out->propertyLong(memberName, value);
+	}
+
+	template<class W> static void putValue(W* out, const char* memberName, unsigned long value) {
+		out->propertyUnsignedLong(memberName, value);
+	}
+
+	template<class W> static void putValue(W* out, const char* memberName, byte value) {
+		out->propertyByte(memberName, value);
+	}
+
+	// doubles are equal within the precision, other values exactly
+	bool sameValue(double a, double b) {
+		return isEqual(a, b, getPrecision());
+	}
+
+	template<class T> static bool sameValue(T a, T b) {
+		return (a == b);
+	}
+
+	// copies text into buffer, cut to size, and returns its length
+	static size_t copyText(char* buffer, size_t size, const char* text) {
+		size_t length = strlen(text);
+		if (size == 0) {
+			return length;
+		} else if (length >= size) {
+			length = size - 1;
+		}
+		memcpy(buffer, text, length);
+		buffer[length] = '\0';
+		return length;
+	}
+
+	// compare-and-set of the typed setters, the type is checked by the caller
+	template<class T> void setTyped(T newValue) {
+		if ((this->valueNull) || (!sameValue(WPropertyTraits<T>::get(this->value), newValue))) {
+			WPropertyValue valueB;
+			WPropertyTraits<T>::put(valueB, newValue);
+			this->setValue(valueB);
+		}
+		afterSet();
+	}
+
+	void afterSet() {
+		if (suppressOnChange) suppressOnChange=false;
+	}
+
+	void requestValue() {
+		if ((!notifying) && (valueRequest)) {
+			unsigned long now = millis();
+			if ((valueRequest->requested) && (now - valueRequest->lastRequest < valueRequest->maxAge)) {
+				return;
+			}
+			valueRequesting = true;
+			valueRequest->callback(this);
+			valueRequesting = false;
+			valueRequest->requested = true;
+			valueRequest->lastRequest = now;
+		}
+	}
+
+	WPropertyValue value = {false};
+
 private:
+	struct ValueRequest {
+		TOnPropertyChange callback;
+		unsigned long maxAge = 0;
+		unsigned long lastRequest = 0;
+		bool requested = false;
+	};
+
+	// only allocated for properties with a deadband or publish interval
+	struct PublishFilter {
+		double deadband = 0.0;
+		double deadbandRelative = 0.0;
+		double lastValue = 0.0;
+		unsigned long minInterval = 0;
+		unsigned long maxInterval = 0;
+		unsigned long lastPublish = 0;
+		bool published = false;
+		bool pending = false;
+	};
+
+	// ordered by size, flags in bits, to keep the many properties of a device small
+	double multipleOf;
 	const char* id;
 	const char* title;
-	WPropertyType type;
-	WPropertyVisibility visibility;
-	bool supportingMqtt;
-	bool mqttSendChangedValues;
-	bool supportingWebthing;
-	byte length;
-	bool readOnly;
 	const char* unit;
-	double multipleOf;
 	TOnPropertyChange onChange;
-	TOnPropertyChange onValueRequest;
-	TOnPropertyChange deviceNotification;
-	TOnPropertyChange settingsNotification;
-	WPropertyValue value = {false};
-	bool valueNull;
-	bool changed;
-	bool requested;
-	bool valueRequesting;
-	bool suppressOnChange;
-	bool notifying;
-
+	ValueRequest* valueRequest;
+	PublishFilter* publishFilter;
+	WPropertyOwner* owner;
+	TOnPropertyChange* settingsNotification;
+	unsigned long changeSequence;
+	byte length;
+	WPropertyType type : 3;
+	WPropertyVisibility visibility : 2;
+	unsigned char decimals : 3;
+	bool supportingMqtt : 1;
+	bool mqttSendChangedValues : 1;
+	bool supportingWebthing : 1;
+	bool readOnly : 1;
+	bool valueNull : 1;
+	bool requested : 1;
+	bool valueRequesting : 1;
+	bool suppressOnChange : 1;
+	bool notifying : 1;
+	bool notifyDeferred : 1;
+	bool notifyPending : 1;
+	bool notifyPendingOnChange : 1;
+	bool notifyPendingPublish : 1;
+	bool ownsOwner : 1;
+	bool ownsSettingsNotification : 1;
 	WConstStringProperty* firstEnum = nullptr;
 
-	void notify() {
-		if (!valueRequesting) {
+	PublishFilter* getPublishFilter() {
+		if (this->publishFilter == nullptr) {
+			this->publishFilter = new PublishFilter();
+			if (this->owner != nullptr) {
+				this->owner->publishFilters++;
+			}
+		}
+		return this->publishFilter;
+	}
+
+	double getNumber() {
+		switch (type) {
+		case BOOLEAN:
+			return (value.asBoolean ? 1 : 0);
+		case DOUBLE:
+			return value.asDouble;
+		case INTEGER:
+			return value.asInteger;
+		case LONG:
+			return value.asLong;
+		case UNSIGNED_LONG:
+			return value.asUnsignedLong;
+		case BYTE:
+			return value.asByte;
+		default:
+			return 0.0;
+		}
+	}
+
+	void publishedAt(unsigned long now) {
+		this->publishFilter->published = true;
+		this->publishFilter->lastPublish = now;
+		this->publishFilter->lastValue = getNumber();
+	}
+
+	// false if the filter drops the change or holds it back
+	bool isPublishing() {
+		PublishFilter* filter = this->publishFilter;
+		if (filter == nullptr) {
+			return true;
+		}
+		if ((filter->published) && (!this->valueNull) && (this->type != STRING)) {
+			double band = max(filter->deadband, filter->deadbandRelative * fabs(filter->lastValue));
+			if (fabs(getNumber() - filter->lastValue) < band) {
+				filter->pending = false;
+				return false;
+			}
+		}
+		unsigned long now = millis();
+		if ((filter->published) && (filter->minInterval > 0) && (now - filter->lastPublish < filter->minInterval)) {
+			filter->pending = true;
+			return false;
+		}
+		filter->pending = false;
+		publishedAt(now);
+		return true;
+	}
+
+	void afterValueChange() {
+		bool publish = isPublishing();
+		if (publish) {
+			setChanged();
+		}
+		valueChanged();
+		notify(publish);
+	}
+
+	void notify(bool publish) {
+		if ((!valueRequesting) && (notifyDeferred)) {
+			notifyPending = true;
+			notifyPendingOnChange = (notifyPendingOnChange || !suppressOnChange);
+			notifyPendingPublish = (notifyPendingPublish || publish);
+		} else if (!valueRequesting) {
 			notifying = true;
 			if (onChange  && !suppressOnChange) {
 				onChange(this);
 			}
-			if (deviceNotification) {
-				deviceNotification(this);
+			if ((owner) && (owner->notification) && (publish)) {
+				owner->notification(this);
 			}
 			if (settingsNotification) {
-				settingsNotification(this);
+				(*settingsNotification)(this);
 			}
 			notifying = false;
 		}
 		if (suppressOnChange) suppressOnChange=false;
 	}
 
-
-	void afterSet() {
-		if (suppressOnChange) suppressOnChange=false;
-	}
-
-
-	void requestValue() {
-		if ((!notifying) && (onValueRequest)) {
-			valueRequesting = true;
-			onValueRequest(this);
-			valueRequesting = false;
-		}
-	}
-
 };
 
 #endif
\ No newline at end of file
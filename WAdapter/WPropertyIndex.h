@@ -0,0 +1,110 @@
+#ifndef W_PROPERTY_INDEX_H
+#define W_PROPERTY_INDEX_H
+
+#include "WProperty.h"
+
+#define WPROPERTY_INDEX_MIN_CAPACITY 8
+
+/*
+ * Hash table of properties by id, open addressing with linear probing.
+ * Properties are only added during setup; the table doubles when it gets
+ * half full. If an id is added twice, the first property is found, as with
+ * a walk through the list.
+ */
+class WPropertyIndex {
+public:
+	typedef uint32_t THash;
+
+	~WPropertyIndex() {
+		if (this->slots) {
+			delete[] this->slots;
+		}
+	}
+
+	// FNV-1a, can be computed character by character while a key is read
+	static THash hashBegin() {
+		return 2166136261UL;
+	}
+
+	static THash hashUpdate(THash hash, char c) {
+		return (hash ^ (uint8_t) c) * 16777619UL;
+	}
+
+	static THash hash(const char* id) {
+		THash result = hashBegin();
+		while (*id) {
+			result = hashUpdate(result, *id++);
+		}
+		return result;
+	}
+
+	void add(WProperty* property) {
+		if ((this->count + 1) * 2 > this->capacity) {
+			resize(this->capacity > 0 ? this->capacity * 2 : WPROPERTY_INDEX_MIN_CAPACITY);
+		}
+		insert(property, hash(property->getId()));
+	}
+
+	WProperty* get(const char* id) {
+		return get(id, hash(id));
+	}
+
+	WProperty* get(const char* id, THash hash) {
+		if (this->count == 0) {
+			return nullptr;
+		}
+		unsigned int mask = this->capacity - 1;
+		for (unsigned int i = hash & mask; this->slots[i].property != nullptr; i = (i + 1) & mask) {
+			if ((this->slots[i].hash == hash) && (strcmp(this->slots[i].property->getId(), id) == 0)) {
+				return this->slots[i].property;
+			}
+		}
+		return nullptr;
+	}
+
+	unsigned int size() {
+		return this->count;
+	}
+
+private:
+	struct Slot {
+		WProperty* property;
+		THash hash;
+	};
+	Slot* slots = nullptr;
+	unsigned int capacity = 0;
+	unsigned int count = 0;
+
+	void insert(WProperty* property, THash hash) {
+		unsigned int mask = this->capacity - 1;
+		unsigned int i = hash & mask;
+		while (this->slots[i].property != nullptr) {
+			if ((this->slots[i].hash == hash) && (strcmp(this->slots[i].property->getId(), property->getId()) == 0)) {
+				return;
+			}
+			i = (i + 1) & mask;
+		}
+		this->slots[i].property = property;
+		this->slots[i].hash = hash;
+		this->count++;
+	}
+
+	void resize(unsigned int capacity) {
+		Slot* old = this->slots;
+		unsigned int oldCapacity = this->capacity;
+		this->slots = new Slot[capacity]();
+		this->capacity = capacity;
+		this->count = 0;
+		for (unsigned int i = 0; i < oldCapacity; i++) {
+			if (old[i].property != nullptr) {
+				insert(old[i].property, old[i].hash);
+			}
+		}
+		if (old) {
+			delete[] old;
+		}
+	}
+
+};
+
+#endif
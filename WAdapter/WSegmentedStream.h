@@ -0,0 +1,165 @@
+#ifndef _SEGMENTED_STREAM_H_
+#define _SEGMENTED_STREAM_H_
+
+#include <Print.h>
+#include <new>
+#include "WBufferPool.h"
+
+#define WSEGMENTED_STREAM_SEGMENT_SIZE 256
+
+/*
+ * Output buffer made of linked segments of WSEGMENTED_STREAM_SEGMENT_SIZE
+ * bytes, so large documents need no contiguous heap block. With a pool,
+ * segments are taken from it and returned by flush(); without one, or with
+ * heapFallback when the pool is empty, they come from the heap and flush()
+ * keeps them for the next content. If no segment is left, write returns 0
+ * and hasError() is true until flush().
+ */
+class WSegmentedStream : public Print {
+public:
+	WSegmentedStream(WBufferPool* pool = nullptr, bool heapFallback = true) {
+		this->pool = pool;
+		this->heapFallback = heapFallback;
+	}
+
+	virtual ~WSegmentedStream() {
+		releaseSegments();
+	}
+
+	// block size for a WBufferPool of segments
+	static size_t getSegmentSize() {
+		return sizeof(Segment);
+	}
+
+	virtual size_t write(uint8_t c) {
+		return write(&c, 1);
+	}
+
+	virtual size_t write(const uint8_t *buffer, size_t size) {
+		size_t written = 0;
+		while (written < size) {
+			if ((this->current == nullptr) || (this->currentLength == WSEGMENTED_STREAM_SEGMENT_SIZE)) {
+				if (!nextSegment()) {
+					this->error = true;
+					break;
+				}
+			}
+			size_t n = min(size - written, (size_t) (WSEGMENTED_STREAM_SEGMENT_SIZE - this->currentLength));
+			memcpy(this->current->data + this->currentLength, buffer + written, n);
+			this->currentLength += n;
+			written += n;
+		}
+		this->totalLength += written;
+		return written;
+	}
+	using Print::write;
+
+	virtual void flush() {
+		if (this->pool != nullptr) {
+			releaseSegments();
+		}
+		this->current = nullptr;
+		this->currentLength = 0;
+		this->totalLength = 0;
+		this->error = false;
+		this->readSegment = nullptr;
+	}
+
+	size_t length() {
+		return this->totalLength;
+	}
+
+	bool hasError() {
+		return this->error;
+	}
+
+	// copies up to size bytes from index on; fastest if called with increasing index
+	size_t read(uint8_t *buffer, size_t size, size_t index) {
+		if ((this->readSegment == nullptr) || (index < this->readStart)) {
+			this->readSegment = this->first;
+			this->readStart = 0;
+		}
+		size_t copied = 0;
+		while ((copied < size) && (index + copied < this->totalLength)) {
+			size_t position = index + copied;
+			while (position >= this->readStart + WSEGMENTED_STREAM_SEGMENT_SIZE) {
+				this->readSegment = this->readSegment->next;
+				this->readStart += WSEGMENTED_STREAM_SEGMENT_SIZE;
+			}
+			size_t offset = position - this->readStart;
+			size_t n = min(size - copied, min((size_t) (WSEGMENTED_STREAM_SEGMENT_SIZE - offset), this->totalLength - position));
+			memcpy(buffer + copied, this->readSegment->data + offset, n);
+			copied += n;
+		}
+		return copied;
+	}
+
+	// writes the content segment by segment
+	size_t writeTo(Print* out) {
+		size_t written = 0;
+		Segment* segment = this->first;
+		while ((segment != nullptr) && (written < this->totalLength)) {
+			size_t n = min((size_t) WSEGMENTED_STREAM_SEGMENT_SIZE, this->totalLength - written);
+			size_t w = out->write(segment->data, n);
+			written += w;
+			if (w < n) {
+				break;
+			}
+			segment = segment->next;
+		}
+		return written;
+	}
+
+private:
+	struct Segment {
+		Segment* next = nullptr;
+		uint8_t data[WSEGMENTED_STREAM_SEGMENT_SIZE];
+	};
+	WBufferPool* pool;
+	bool heapFallback;
+	Segment* first = nullptr;
+	Segment* current = nullptr;
+	size_t currentLength = 0;
+	size_t totalLength = 0;
+	bool error = false;
+	Segment* readSegment = nullptr;
+	size_t readStart = 0;
+
+	bool nextSegment() {
+		Segment* next = (this->current == nullptr ? this->first : this->current->next);
+		if (next == nullptr) {
+			void* block = (this->pool != nullptr ? this->pool->checkout() : nullptr);
+			if (block != nullptr) {
+				next = new (block) Segment;
+			} else if ((this->pool == nullptr) || (this->heapFallback)) {
+				next = new (std::nothrow) Segment;
+			}
+			if (next == nullptr) {
+				return false;
+			}
+			if (this->current == nullptr) {
+				this->first = next;
+			} else {
+				this->current->next = next;
+			}
+		}
+		this->current = next;
+		this->currentLength = 0;
+		return true;
+	}
+
+	void releaseSegments() {
+		while (this->first != nullptr) {
+			Segment* segment = this->first;
+			this->first = segment->next;
+			if ((this->pool != nullptr) && (this->pool->contains(segment))) {
+				this->pool->checkin(segment);
+			} else {
+				delete segment;
+			}
+		}
+	}
+
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "EEPROM.h"
 #include "WLog.h"
 #include "WProperty.h"
+#include "WPropertyIndex.h"
 
 const byte STORED_FLAG_OLDLOW = 0x59; //1.00 ..
 const byte STORED_FLAG_OLDHIGH = 0x63; //1.02
@@ -19,6 +20,7 @@ public:
 	WProperty* value;
 	int address;
 	bool networkSetting;
+	bool dirty = false;
 	WSettingItem* next = nullptr;
 };
 const int NETWORKSETTINGS_UNKNOWN = 0;
@@ -78,7 +80,9 @@ public:
 	void save(WProperty* property) {
 		WSettingItem* settingItem = firstSetting;
 		while (settingItem != nullptr) {
-			if (property == settingItem->value) {
+			if ((property == settingItem->value) && (this->transactionDepth > 0)) {
+				settingItem->dirty = true;
+			} else if (property == settingItem->value) {
 				EEPROM.begin(EEPROM_SIZE);
 				save(settingItem);
 				EEPROM.commit();
@@ -102,10 +106,42 @@ public:
 		EEPROM.end();
 	}
 
-	bool existsSetting(String id) {
+	// saves of single properties are collected and written with one commit
+	void beginTransaction() {
+		this->transactionDepth++;
+	}
+
+	void commitTransaction() {
+		if ((this->transactionDepth == 0) || (--this->transactionDepth > 0)) {
+			return;
+		}
+		bool dirty = false;
+		WSettingItem* settingItem = firstSetting;
+		while (settingItem != nullptr) {
+			if (settingItem->dirty) {
+				if (!dirty) {
+					EEPROM.begin(EEPROM_SIZE);
+					dirty = true;
+				}
+				save(settingItem);
+				settingItem->dirty = false;
+			}
+			settingItem = settingItem->next;
+		}
+		if (dirty) {
+			EEPROM.commit();
+			EEPROM.end();
+		}
+	}
+
+	bool existsSetting(const char* id) {
 		return (getSetting(id) != nullptr);
 	}
 
+	bool existsSetting(const String& id) {
+		return existsSetting(id.c_str());
+	}
+
 	bool existsSettingsNetwork() {
 		return this->_existsSettingsNetwork;
 	}
@@ -131,16 +167,12 @@ public:
 		return (this->lastSetting != nullptr ?  this->lastSetting->address : 0);
 	}
 
-	WProperty* getSetting(String id) {
-		WSettingItem* settingItem = firstSetting;
-		while (settingItem != nullptr) {
-			WProperty* setting = settingItem->value;
-			if (id.equals(setting->getId())) {
-				return setting;
-			}
-			settingItem = settingItem->next;
-		}
-		return nullptr;
+	WProperty* getSetting(const char* id) {
+		return this->settingIndex.get(id);
+	}
+
+	WProperty* getSetting(const String& id) {
+		return getSetting(id.c_str());
 	}
 
 	bool exists(WProperty* property) {
@@ -217,7 +249,7 @@ public:
 			} else {
 				log->trace(F("NOT Loading setting %s (!current)"), property->getId());
 			}
-			property->setSettingsNotification([this](WProperty* property) {save(property);});
+			property->setSettingsNotification(&this->saveNotification);
 		}
 	}
 
@@ -361,6 +393,7 @@ protected:
 		WSettingItem* settingItem = new WSettingItem();
 		settingItem->value = setting;
 		settingItem->networkSetting = this->addingNetworkSettings;
+		this->settingIndex.add(setting);
 		if (this->lastSetting == nullptr) {
 			settingItem->address = 0;
 			this->firstSetting = settingItem;
@@ -437,6 +470,10 @@ private:
 	unsigned int _applicationSettingsVersion;
 	WSettingItem* firstSetting = nullptr;
 	WSettingItem* lastSetting = nullptr;
+	WPropertyIndex settingIndex;
+	unsigned int transactionDepth = 0;
+	// shared by all settings
+	WProperty::TOnPropertyChange saveNotification = [this](WProperty* property) {save(property);};
 
 	const char* readString(int address, int length) {
 		char* data = new char[length+ 1]; //Max 100 Bytes
@@ -3,6 +3,11 @@
 
 #include <Stream.h>
 
+/*
+ * Text buffer with a Stream interface. read() moves a cursor over the
+ * text; the unread rest is moved to the front only when a write needs the
+ * room, so the text stays contiguous for c_str().
+ */
 class WStringStream : public Stream {
 public:
     
@@ -19,37 +24,45 @@ public:
 	}
 
     // Stream methods
+    // unread bytes
     virtual int available() {
-    	return getMaxLength() - position;
+    	return this->position - this->readPosition;
     }
 
     virtual int read() {
-    	if (position > 0) {
-    		char c = string[0];
-    		for (unsigned int i = 1; i <= position; i++) {
-    			string[i - 1] = string[i];
+    	if (readPosition < position) {
+    		uint8_t c = (uint8_t) string[readPosition];
+    		readPosition++;
+    		if (readPosition == position) {
+    			// all read, start at the front again; unlike flush() a write error stays
+    			position = 0;
+    			readPosition = 0;
+    			string[0] = '\0';
     		}
-			position--;
     		return c;
     	}
     	return -1;
     }
 
     virtual int peek() {
-    	if (position > 0) {
-    	    char c = string[0];
-    	    return c;
+    	if (readPosition < position) {
+    	    return (uint8_t) string[readPosition];
     	}
     	return -1;
     }
 
     virtual void flush() {
     	this->position = 0;
+    	this->readPosition = 0;
     	this->string[0] = '\0';
+    	clearWriteError();
     }
 
     // Print methods
     virtual size_t write(uint8_t c) {
+    	if (position >= maxLength) {
+    		compact();
+    	}
     	if (position < maxLength) {
     		string[position] = (char) c;
     		position++;
@@ -60,8 +73,22 @@ public:
     	}
     }
 
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+    	if (size > maxLength - position) {
+    		compact();
+    	}
+    	if (size > maxLength - position) {
+    		size = maxLength - position;
+    	}
+    	memcpy(&string[position], buffer, size);
+    	position += size;
+    	string[position] = '\0';
+    	return size;
+    }
+    using Print::write;
+
     unsigned int length() {
-        return this->position;
+        return this->position - this->readPosition;
     }
 
     unsigned int getMaxLength() {
@@ -69,13 +96,26 @@ public:
     }
 
     char charAt(int index) {
-    	return this->string[index];
+    	return this->string[this->readPosition + index];
     }
 
+	/*
+	 * Formats into the free space; the format can be in flash. Output that
+	 * doesn't fit is cut, and the write error is set.
+	 */
 	size_t printf(const char *format, va_list args) {
-		size_t written = vsnprintf(&string[position], maxLength - position-1, format, args);
-		position+=written;
-		return written;	
+		compact();
+		size_t space = maxLength - position;
+		int written = vsnprintf_P(&string[position], space + 1, format, args);
+		if (written < 0) {
+			string[position] = '\0';
+			return 0;
+		} else if ((size_t) written > space) {
+			setWriteError();
+			written = space;
+		}
+		position += written;
+		return written;
 	}
 	size_t printf(const char *format, ...) {
 		va_list args;
@@ -85,17 +125,7 @@ public:
 		return len;
 	}
 	size_t printf(const __FlashStringHelper *format, va_list args) {
-		char buf[1024];
-		size_t size = sizeof buf;
-		PGM_P p = reinterpret_cast<PGM_P>(format);
-		char c;
-		unsigned int pos=0;
-		for (; pos < size-1 && (c = pgm_read_byte(p++)) != 0; pos++) {
-				buf[pos]=c;
-		}
-		buf[pos]='\0';
-		size_t len = printf(buf, args);
-		return len;
+		return printf(reinterpret_cast<PGM_P>(format), args);
 	}
 	
 	size_t printf(const __FlashStringHelper *format, ...) {
@@ -115,13 +145,23 @@ public:
 	}
 
     const char* c_str() {
-		return this->string;
+		return this->string + this->readPosition;
     }
 
 private:
     char* string;
     unsigned int maxLength;
     unsigned int position;
+    unsigned int readPosition;
+
+    // moves the unread text to the front
+    void compact() {
+    	if (readPosition > 0) {
+    		position -= readPosition;
+    		memmove(string, string + readPosition, position + 1);
+    		readPosition = 0;
+    	}
+    }
 };
 
 #endif // _STRING_STREAM_H_
@@ -0,0 +1,269 @@
+#ifndef W_STRUCTURE_GENERATOR_H
+#define W_STRUCTURE_GENERATOR_H
+
+#include <new>
+#include "WDevice.h"
+
+/* Print that keeps only the bytes from skip to skip + maxLength of everything written to it */
+class WWindowPrint: public Print {
+public:
+	WWindowPrint(uint8_t* buffer, size_t skip, size_t maxLength) {
+		this->buffer = buffer;
+		this->skip = skip;
+		this->maxLength = maxLength;
+		this->total = 0;
+		this->filled = 0;
+	}
+
+	virtual size_t write(uint8_t c) {
+		return write(&c, 1);
+	}
+
+	virtual size_t write(const uint8_t *data, size_t size) {
+		size_t start = total;
+		total += size;
+		if ((total <= skip) || (filled == maxLength)) {
+			return size;
+		}
+		if (start < skip) {
+			data += skip - start;
+			size -= skip - start;
+		}
+		if (size > maxLength - filled) {
+			size = maxLength - filled;
+		}
+		memcpy(buffer + filled, data, size);
+		filled += size;
+		return size;
+	}
+	using Print::write;
+
+	size_t total;
+	size_t filled;
+
+private:
+	uint8_t* buffer;
+	size_t skip;
+	size_t maxLength;
+};
+
+/*
+ * Writes the Thing Descriptions of all visible devices as a JSON array into
+ * buffers of any size, for chunked responses. Devices are copied from their
+ * cached description; if there isn't one, the device header, each property
+ * and the device end are serialized separately. A piece that doesn't fit
+ * into the buffer is kept until the next call continues it; cached
+ * descriptions are continued directly from the cache. If the structure of
+ * the device being written changes between calls, the generator fails and
+ * the response has to be aborted.
+ */
+class WStructureGenerator {
+public:
+	WStructureGenerator(WDevice* firstDevice, const char* deviceHRef, WPropertyVisibility visibility, bool array = true, bool useCache = true) {
+		this->device = firstDevice;
+		this->deviceHRef = deviceHRef;
+		this->visibility = visibility;
+		this->array = array;
+		this->useCache = useCache;
+		this->property = nullptr;
+		this->offset = 0;
+		this->piece = nullptr;
+		this->pieceLength = 0;
+		this->failed = false;
+		this->firstDevice = true;
+		this->step = (array ? ARRAY_BEGIN : DEVICE_BEGIN);
+		// a single device is written without the array
+		this->lastDevice = (array ? nullptr : firstDevice);
+		skipInvisibleDevices();
+		if (array) {
+			this->structureVersion = (this->device != nullptr ? this->device->getStructureVersion() : 0);
+		} else {
+			startDevice();
+		}
+	}
+
+	~WStructureGenerator() {
+		dropPiece();
+	}
+
+	// fills buffer with the next part of the document, returns 0 at the end or on failure
+	size_t fill(uint8_t* buffer, size_t maxLength) {
+		if ((step != DONE) && (device != nullptr) && (device->getStructureVersion() != structureVersion)) {
+			// pieces already sent don't match the device anymore
+			failed = true;
+			step = DONE;
+		}
+		size_t filled = 0;
+		while ((step != DONE) && (filled < maxLength)) {
+			WWindowPrint window(buffer + filled, offset, maxLength - filled);
+			if (piece != nullptr) {
+				window.write(piece, pieceLength);
+			} else {
+				writeStep(&window);
+			}
+			filled += window.filled;
+			if (offset + window.filled >= window.total) {
+				offset = 0;
+				dropPiece();
+				nextStep();
+			} else {
+				if ((piece == nullptr) && (step != DEVICE_CACHED)) {
+					keepPiece(window.total);
+				}
+				offset += window.filled;
+			}
+		}
+		return filled;
+	}
+
+	bool isDone() {
+		return (step == DONE);
+	}
+
+	bool isFailed() {
+		return failed;
+	}
+
+private:
+	enum Step {
+		ARRAY_BEGIN, DEVICE_BEGIN, DEVICE_CACHED, PROPERTY, DEVICE_END, ARRAY_END, DONE
+	};
+	Step step;
+	WDevice* device;
+	WDevice* lastDevice;
+	WProperty* property;
+	const char* deviceHRef;
+	WPropertyVisibility visibility;
+	bool array;
+	bool useCache;
+	bool firstDevice;
+	bool firstProperty;
+	bool failed;
+	size_t offset;
+	unsigned long structureVersion;
+	uint8_t* piece;
+	size_t pieceLength;
+	String href;
+
+	// serializes the current piece once more, so later calls copy the rest instead of serializing it again.
+	// Without memory for it, the piece is serialized again on each call
+	void keepPiece(size_t length) {
+		piece = new (std::nothrow) uint8_t[length];
+		if (piece != nullptr) {
+			WWindowPrint out(piece, 0, length);
+			writeStep(&out);
+			pieceLength = out.filled;
+		}
+	}
+
+	void dropPiece() {
+		delete[] piece;
+		piece = nullptr;
+		pieceLength = 0;
+	}
+
+	void writeStep(Print* out) {
+		switch (step) {
+		case ARRAY_BEGIN:
+			out->write(BBEGIN);
+			break;
+		case DEVICE_BEGIN: {
+			if (!firstDevice) out->write(COMMA);
+			WJson json(out);
+			device->toJsonStructureBegin(&json);
+			break;
+		}
+		case DEVICE_CACHED: {
+			if (!firstDevice) out->write(COMMA);
+			WStringStream* structure = device->getJsonStructure(deviceHRef, visibility);
+			if (structure != nullptr) {
+				out->write((const uint8_t*) structure->c_str(), structure->length());
+			} else {
+				// cache was dropped meanwhile, same bytes
+				WJson json(out);
+				device->toJsonStructure(&json, deviceHRef, visibility);
+			}
+			break;
+		}
+		case PROPERTY: {
+			if (!firstProperty) out->write(COMMA);
+			WJson json(out);
+			property->toJsonStructure(&json, property->getId(), href.c_str());
+			break;
+		}
+		case DEVICE_END: {
+			WJson json(out);
+			device->toJsonStructureEnd(&json);
+			break;
+		}
+		case ARRAY_END:
+			out->write(BEND);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void nextStep() {
+		switch (step) {
+		case ARRAY_BEGIN:
+			step = DEVICE_BEGIN;
+			startDevice();
+			break;
+		case DEVICE_BEGIN:
+			href = (String) deviceHRef + URI_SEP + device->getId();
+			property = device->firstProperty;
+			firstProperty = true;
+			skipInvisibleProperties();
+			step = (property != nullptr ? PROPERTY : DEVICE_END);
+			break;
+		case PROPERTY:
+			firstProperty = false;
+			property = property->next;
+			skipInvisibleProperties();
+			if (property == nullptr) step = DEVICE_END;
+			break;
+		case DEVICE_CACHED:
+		case DEVICE_END:
+			firstDevice = false;
+			device = (device == lastDevice ? nullptr : device->next);
+			skipInvisibleDevices();
+			step = DEVICE_BEGIN;
+			startDevice();
+			break;
+		case ARRAY_END:
+			step = DONE;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// decides how the next device is written
+	void startDevice() {
+		if (device == nullptr) {
+			step = (array ? ARRAY_END : DONE);
+			return;
+		}
+		structureVersion = device->getStructureVersion();
+		if ((useCache) && (device->getJsonStructure(deviceHRef, visibility) != nullptr)) {
+			step = DEVICE_CACHED;
+		} else {
+			step = DEVICE_BEGIN;
+		}
+	}
+
+	void skipInvisibleDevices() {
+		while ((array) && (device != nullptr) && (!device->isVisible(visibility))) {
+			device = device->next;
+		}
+	}
+
+	void skipInvisibleProperties() {
+		while ((property != nullptr) && (!property->isVisible(visibility))) {
+			property = property->next;
+		}
+	}
+};
+
+#endif
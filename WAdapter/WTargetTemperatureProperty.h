@@ -1,14 +1,14 @@
 #ifndef W_TARGET_TEMPERATURE_PROPERTY_H
 #define W_TARGET_TEMPERATURE_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
 const char* ATTYPE_TARGETTEMPERATUR PROGMEM = "TargetTemperatureProperty";
 
-class WTargetTemperatureProperty: public WProperty {
+class WTargetTemperatureProperty: public WTypedProperty<double> {
 public:
 	WTargetTemperatureProperty(const char* id, const char* title)
-	: WProperty(id, title, DOUBLE) {
+	: WTypedProperty<double>(id, title) {
 		this->atType = ATTYPE_TARGETTEMPERATUR;
 		this->setUnit(STR_CELSIUS);
 	}
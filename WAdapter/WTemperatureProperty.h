@@ -1,12 +1,12 @@
 #ifndef W_TEMPERATURE_PROPERTY_H
 #define W_TEMPERATURE_PROPERTY_H
 
-#include "WProperty.h"
+#include "WTypedProperty.h"
 
-class WTemperatureProperty: public WProperty {
+class WTemperatureProperty: public WTypedProperty<double> {
 public:
 	WTemperatureProperty(const char* id, const char* title)
-	: WProperty(id, title, DOUBLE) {
+	: WTypedProperty<double>(id, title) {
 		this->atType = "TemperatureProperty";
 		this->setUnit("celsius");
 	}
@@ -0,0 +1,62 @@
+#ifndef W_TYPED_PROPERTY_H
+#define W_TYPED_PROPERTY_H
+
+#include "WProperty.h"
+
+/*
+ * Property with the value type fixed at compile time. get(), set(), parsing
+ * and JSON/CBOR output go straight to the value without checking the type.
+ * Devices and settings still handle it as a WProperty, and getDouble() etc.
+ * of the base keep working.
+ */
+template<class T> class WTypedProperty: public WProperty {
+public:
+	typedef WPropertyTraits<T> Traits;
+
+	WTypedProperty(const char* id, const char* title)
+	: WProperty(id, title, Traits::TYPE) {
+	}
+
+	T get() {
+		requestValue();
+		return (!isNull() ? Traits::get(this->value) : T());
+	}
+
+	void set(T newValue) {
+		setTyped(newValue);
+	}
+
+	bool equals(T other) {
+		return ((!isNull()) && (sameValue(Traits::get(this->value), other)));
+	}
+
+	using WProperty::parse;
+
+	bool parse(const char* data, size_t length) {
+		if ((!isReadOnly()) && (data != nullptr)) {
+			T newValue;
+			parseValue(data, length, newValue);
+			set(newValue);
+			return true;
+		}
+		return false;
+	}
+
+	using WProperty::toString;
+
+	size_t toString(char* buffer, size_t size) {
+		char number[WPROPERTY_STRING_LENGTH];
+		return copyText(buffer, size, formatValue(number, get()));
+	}
+
+	void toJsonValue(WJson* json, bool onlyValue=false) {
+		putValue(json, (onlyValue ? nullptr : getId()), get());
+	}
+
+	void toCborValue(WCbor* cbor, bool onlyValue=false) {
+		putValue(cbor, (onlyValue ? nullptr : getId()), get());
+	}
+
+};
+
+#endif
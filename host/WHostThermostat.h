@@ -0,0 +1,62 @@
+#ifndef W_HOST_THERMOSTAT_H
+#define W_HOST_THERMOSTAT_H
+
+#include "WDevice.h"
+
+const char* const MODES[] PROGMEM = {"off", "heat", "cool"};
+
+/* Sample device for the host build, used by wadapter_host and the benchmarks. */
+class WHostThermostat: public WDevice {
+public:
+	WHostThermostat(WNetwork* network)
+			: WDevice(network, "thermostat", "thermostat", network->getIdx(), DEVICE_TYPE_THERMOSTAT) {
+		this->providingConfigPage = false;
+		// each changed property also to its own topic, with --single-values
+		this->setMqttSendChangedValues(true);
+		this->lastUpdate = 0;
+		this->on = new WOnOffProperty("on", "Power");
+		this->on->setBoolean(true);
+		this->addProperty(on);
+		this->temperature = new WTemperatureProperty("temperature", "Actual");
+		this->temperature->setReadOnly(true);
+		this->temperature->setDouble(21.0);
+		this->addProperty(temperature);
+		this->targetTemperature = new WTargetTemperatureProperty("targetTemperature", "Target");
+		this->targetTemperature->setDouble(22.5);
+		this->addProperty(targetTemperature);
+		this->mode = new WEnumProperty("mode", "Mode", MODES, 3);
+		this->mode->setString("heat");
+		this->addProperty(mode);
+		this->fan = new WLevelIntProperty("fan", "Fan", 0, 5);
+		this->fan->setInteger(2);
+		this->addProperty(fan);
+	}
+
+	void loop(unsigned long now) {
+		// the actual temperature follows the target slowly
+		if (now - lastUpdate > 5000) {
+			lastUpdate = now;
+			double actual = temperature->getDouble();
+			double target = (on->getBoolean() ? targetTemperature->getDouble() : 18.0);
+			if (actual < target - 0.05) {
+				temperature->setDouble(actual + 0.1);
+			} else if (actual > target + 0.05) {
+				temperature->setDouble(actual - 0.1);
+			}
+		}
+	}
+
+	bool isDeviceStateComplete() {
+		return true;
+	}
+
+private:
+	WProperty* on;
+	WProperty* temperature;
+	WProperty* targetTemperature;
+	WProperty* mode;
+	WProperty* fan;
+	unsigned long lastUpdate;
+};
+
+#endif
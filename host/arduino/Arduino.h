@@ -0,0 +1,72 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+ * Host stand-in for the ESP8266 Arduino core. Only the part of the API that
+ * WAdapter uses is provided, with the same semantics as the ESP8266 core
+ * (per-byte virtual Print::write, String growth, EEPROM commit rules) so that
+ * profiles taken on the workstation point at the same hot spots as on the chip.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "pgmspace.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x00
+#define OUTPUT       0x01
+#define INPUT_PULLUP 0x02
+
+#define PI 3.1415926535897932384626433832795
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+char* itoa(int value, char* result, int base);
+char* ltoa(long value, char* result, int base);
+char* utoa(unsigned int value, char* result, int base);
+char* ultoa(unsigned long value, char* result, int base);
+char* dtostrf(double number, signed char width, unsigned char prec, char* s);
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "Esp.h"
+#include "Updater.h"
+
+/*
+ * Host only: remembers argv so ESP.restart() can re-exec the process,
+ * the same way the chip boots into setup() again.
+ */
+void hostInit(int argc, char** argv);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HOST_DNSSERVER_H
+#define HOST_DNSSERVER_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+enum class DNSReplyCode {
+	NoError = 0, FormError = 1, ServerFailure = 2, NonExistentDomain = 3, NotImplemented = 4, Refused = 5
+};
+
+/* Host stand-in for the captive portal DNS server; it never answers. */
+class DNSServer {
+public:
+	void processNextRequest() {
+	}
+	void setErrorReplyCode(const DNSReplyCode &replyCode) {
+	}
+	void setTTL(const uint32_t &ttl) {
+	}
+	bool start(const uint16_t &port, const String &domainName, const IPAddress &resolvedIP) {
+		return true;
+	}
+	void stop() {
+	}
+};
+
+#endif
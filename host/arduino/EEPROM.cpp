@@ -0,0 +1,95 @@
+#include "EEPROM.h"
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+EEPROMClass EEPROM;
+
+const char* EEPROMClass::getFileName() {
+	const char* fileName = getenv("WADAPTER_EEPROM");
+	return (fileName && strlen(fileName) ? fileName : "wadapter-eeprom.bin");
+}
+
+void EEPROMClass::begin(size_t size) {
+	if (size <= 0) {
+		return;
+	}
+	if (size > SPI_FLASH_SEC_SIZE) {
+		size = SPI_FLASH_SEC_SIZE;
+	}
+	size = (size + 3) & (~3);
+	if (data && size != this->size) {
+		delete[] data;
+		data = new uint8_t[size];
+	} else if (!data) {
+		data = new uint8_t[size];
+	}
+	this->size = size;
+	// an erased sector reads as 0xFF
+	memset(data, 0xFF, size);
+	FILE* f = fopen(getFileName(), "rb");
+	if (f) {
+		size_t n = fread(data, 1, size, f);
+		(void) n;
+		fclose(f);
+	}
+	dirty = false;
+}
+
+uint8_t EEPROMClass::read(int const address) {
+	if (address < 0 || (size_t) address >= size) {
+		return 0;
+	}
+	if (!data) {
+		return 0;
+	}
+	return data[address];
+}
+
+void EEPROMClass::write(int const address, uint8_t const value) {
+	if (address < 0 || (size_t) address >= size) {
+		return;
+	}
+	if (!data) {
+		return;
+	}
+	if (data[address] != value) {
+		data[address] = value;
+		dirty = true;
+	}
+}
+
+bool EEPROMClass::commit() {
+	if (!size) {
+		return false;
+	}
+	if (!dirty) {
+		return true;
+	}
+	if (!data) {
+		return false;
+	}
+	FILE* f = fopen(getFileName(), "wb");
+	if (!f) {
+		return false;
+	}
+	bool ret = (fwrite(data, 1, size, f) == size);
+	fclose(f);
+	if (ret) {
+		dirty = false;
+		commitCount++;
+	}
+	return ret;
+}
+
+void EEPROMClass::end() {
+	if (!size) {
+		return;
+	}
+	commit();
+	if (data) {
+		delete[] data;
+	}
+	data = nullptr;
+	size = 0;
+	dirty = false;
+}
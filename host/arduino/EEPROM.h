@@ -0,0 +1,67 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "Arduino.h"
+
+/*
+ * Host stand-in for the emulated EEPROM: the flash sector is a file
+ * (WADAPTER_EEPROM environment variable, default "wadapter-eeprom.bin").
+ * begin(), commit() and end() follow the ESP8266 core: begin() re-reads the
+ * sector, commit() only writes when something changed.
+ */
+class EEPROMClass {
+public:
+	void begin(size_t size);
+	uint8_t read(int const address);
+	void write(int const address, uint8_t const val);
+	bool commit();
+	void end();
+
+	uint8_t * getDataPtr() {
+		dirty = true;
+		return data;
+	}
+	const uint8_t * getConstDataPtr() const {
+		return data;
+	}
+
+	template<typename T> T &get(int const address, T &t) {
+		if (address < 0 || address + sizeof(T) > size) {
+			return t;
+		}
+		memcpy((uint8_t*) &t, data + address, sizeof(T));
+		return t;
+	}
+
+	template<typename T> const T &put(int const address, const T &t) {
+		if (address < 0 || address + sizeof(T) > size) {
+			return t;
+		}
+		if (memcmp(data + address, (const uint8_t*) &t, sizeof(T)) != 0) {
+			dirty = true;
+			memcpy(data + address, (const uint8_t*) &t, sizeof(T));
+		}
+		return t;
+	}
+
+	size_t length() {
+		return size;
+	}
+
+	/* Host only: number of commits that actually wrote the sector. */
+	unsigned long getCommitCount() {
+		return commitCount;
+	}
+
+private:
+	uint8_t* data = nullptr;
+	size_t size = 0;
+	bool dirty = false;
+	unsigned long commitCount = 0;
+
+	const char* getFileName();
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,49 @@
+#include "ESP8266WiFi.h"
+
+ESP8266WiFiClass WiFi;
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char *passphrase) {
+	this->currentStatus = WL_CONNECTED;
+	WiFiEventStationModeGotIP event;
+	event.ip = localIP();
+	event.mask = IPAddress(255, 0, 0, 0);
+	event.gw = IPAddress(127, 0, 0, 1);
+	for (std::weak_ptr<WiFiEventHandlerOpaque> &weak : handlers) {
+		WiFiEventHandler handler = weak.lock();
+		if ((handler) && (handler->onGotIP)) {
+			handler->onGotIP(event);
+		}
+	}
+	return currentStatus;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifioff) {
+	bool wasConnected = (this->currentStatus == WL_CONNECTED);
+	this->currentStatus = WL_DISCONNECTED;
+	if (wasConnected) {
+		WiFiEventStationModeDisconnected event;
+		memset(event.bssid, 0, sizeof(event.bssid));
+		event.reason = 8;
+		for (std::weak_ptr<WiFiEventHandlerOpaque> &weak : handlers) {
+			WiFiEventHandler handler = weak.lock();
+			if ((handler) && (handler->onDisconnected)) {
+				handler->onDisconnected(event);
+			}
+		}
+	}
+	return true;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f) {
+	WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>();
+	handler->onGotIP = f;
+	handlers.push_back(handler);
+	return handler;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f) {
+	WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>();
+	handler->onDisconnected = f;
+	handlers.push_back(handler);
+	return handler;
+}
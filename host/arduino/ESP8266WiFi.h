@@ -0,0 +1,135 @@
+#ifndef HOST_ESP8266WIFI_H
+#define HOST_ESP8266WIFI_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+typedef enum WiFiMode {
+	WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum WiFiPhyMode {
+	WIFI_PHY_MODE_11B = 1, WIFI_PHY_MODE_11G = 2, WIFI_PHY_MODE_11N = 3
+} WiFiPhyMode_t;
+
+enum wl_enc_type {
+	ENC_TYPE_WEP = 5, ENC_TYPE_TKIP = 2, ENC_TYPE_CCMP = 4, ENC_TYPE_NONE = 7, ENC_TYPE_AUTO = 8
+};
+
+typedef enum {
+	WL_NO_SHIELD = 255,
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL = 1,
+	WL_SCAN_COMPLETED = 2,
+	WL_CONNECTED = 3,
+	WL_CONNECT_FAILED = 4,
+	WL_CONNECTION_LOST = 5,
+	WL_WRONG_PASSWORD = 6,
+	WL_DISCONNECTED = 7
+} wl_status_t;
+
+struct WiFiEventStationModeGotIP {
+	IPAddress ip;
+	IPAddress mask;
+	IPAddress gw;
+};
+
+struct WiFiEventStationModeDisconnected {
+	String ssid;
+	uint8_t bssid[6];
+	uint8_t reason;
+};
+
+struct WiFiEventHandlerOpaque {
+	std::function<void(const WiFiEventStationModeGotIP&)> onGotIP;
+	std::function<void(const WiFiEventStationModeDisconnected&)> onDisconnected;
+};
+
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+/*
+ * Host stand-in for the WiFi station/AP state machine. The workstation is
+ * always "in range": begin() connects immediately with the loopback address
+ * and fires the got-IP handlers, disconnect() fires the disconnected handlers.
+ */
+class ESP8266WiFiClass {
+public:
+	bool mode(WiFiMode_t m) {
+		this->currentMode = m;
+		return true;
+	}
+	WiFiMode_t getMode() {
+		return currentMode;
+	}
+	uint8_t encryptionType(uint8_t networkItem) {
+		return ENC_TYPE_CCMP;
+	}
+	void setOutputPower(float dBm) {
+	}
+	bool setPhyMode(WiFiPhyMode_t mode) {
+		return true;
+	}
+	bool setAutoConnect(bool autoConnect) {
+		return true;
+	}
+	bool setAutoReconnect(bool autoReconnect) {
+		return true;
+	}
+	void persistent(bool persistent) {
+	}
+
+	wl_status_t begin(const char* ssid, const char *passphrase = nullptr);
+	bool disconnect(bool wifioff = false);
+	wl_status_t status() {
+		return currentStatus;
+	}
+	bool hostname(const char* aHostname) {
+		hostName = aHostname;
+		return true;
+	}
+	bool hostname(const String& aHostname) {
+		return hostname(aHostname.c_str());
+	}
+	String hostname() {
+		return hostName;
+	}
+
+	bool softAP(const char* ssid, const char* passphrase = nullptr) {
+		this->apRunning = true;
+		return true;
+	}
+	bool softAPdisconnect(bool wifioff = false) {
+		this->apRunning = false;
+		return true;
+	}
+	IPAddress softAPIP() {
+		return IPAddress(192, 168, 4, 1);
+	}
+	IPAddress localIP() {
+		return (currentStatus == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress());
+	}
+	String macAddress() {
+		return String("02:00:00:C0:FF:EE");
+	}
+	int32_t RSSI() {
+		return rssi;
+	}
+
+	WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f);
+	WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f);
+
+	/* Host only: signal strength reported by RSSI(). */
+	int32_t rssi = -60;
+
+private:
+	WiFiMode_t currentMode = WIFI_OFF;
+	wl_status_t currentStatus = WL_DISCONNECTED;
+	bool apRunning = false;
+	String hostName;
+	std::vector<std::weak_ptr<WiFiEventHandlerOpaque>> handlers;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
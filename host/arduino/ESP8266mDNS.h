@@ -0,0 +1,37 @@
+#ifndef HOST_ESP8266MDNS_H
+#define HOST_ESP8266MDNS_H
+
+#include "Arduino.h"
+
+class MDNSResponder {
+public:
+	bool begin(const char* hostName) {
+		this->hostName = hostName;
+		return true;
+	}
+	bool begin(const String& hostName) {
+		return begin(hostName.c_str());
+	}
+	bool end() {
+		return true;
+	}
+	bool update() {
+		return true;
+	}
+	bool addService(const char* service, const char* proto, uint16_t port) {
+		return true;
+	}
+	bool addServiceTxt(const char* service, const char* proto, const char* key, const char* value) {
+		return true;
+	}
+	bool addServiceTxt(const char* service, const char* proto, const char* key, const String& value) {
+		return addServiceTxt(service, proto, key, value.c_str());
+	}
+
+private:
+	String hostName;
+};
+
+extern MDNSResponder MDNS;
+
+#endif
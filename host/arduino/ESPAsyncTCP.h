@@ -0,0 +1,70 @@
+#ifndef HOST_ESPASYNCTCP_H
+#define HOST_ESPASYNCTCP_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <functional>
+
+class AsyncClient;
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+
+/* Host stand-in for the async TCP connection behind a web request. */
+class AsyncClient {
+public:
+	AsyncClient(IPAddress remoteIP = IPAddress(127, 0, 0, 1), uint16_t remotePort = 0) {
+		this->_remoteIP = remoteIP;
+		this->_remotePort = remotePort;
+		this->_closed = false;
+		this->_discarded = false;
+		this->_discardArg = nullptr;
+	}
+	IPAddress remoteIP() {
+		return _remoteIP;
+	}
+	uint16_t remotePort() {
+		return _remotePort;
+	}
+	IPAddress localIP() {
+		return IPAddress(127, 0, 0, 1);
+	}
+	bool connected() {
+		return !_closed;
+	}
+	// called when the connection is gone; the web server deletes the request in it
+	void onDisconnect(AcConnectHandler cb, void* arg = nullptr) {
+		_discardCb = cb;
+		_discardArg = arg;
+	}
+	/*
+	 * Like ESPAsyncTCP: close() drops the connection once the current
+	 * callback returned, close(true) at once, and runs the disconnect
+	 * callback before it returns. Whatever the callback deletes is gone
+	 * for the caller then.
+	 */
+	void close(bool now = false) {
+		_closed = true;
+		if (now) {
+			_discard();
+		}
+	}
+	// the transport ends the connection
+	void _discard() {
+		_closed = true;
+		if (!_discarded) {
+			_discarded = true;
+			if (_discardCb) {
+				_discardCb(_discardArg, this);
+			}
+		}
+	}
+
+private:
+	IPAddress _remoteIP;
+	uint16_t _remotePort;
+	bool _closed;
+	bool _discarded;
+	AcConnectHandler _discardCb;
+	void* _discardArg;
+};
+
+#endif
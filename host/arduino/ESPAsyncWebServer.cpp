@@ -0,0 +1,837 @@
+#include "ESPAsyncWebServer.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/*
+ * AsyncWebServerRequest
+ */
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client)
+	: _tempObject(nullptr), _server(server), _client(client), _handler(nullptr), _response(nullptr),
+	  _method(HTTP_ANY), _contentLength(0), _parsedLength(0), _isMultipart(false), _isPlainPost(false) {
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+	// requests live as long as their connection
+	if (_onDisconnectfn) {
+		_onDisconnectfn();
+	}
+	for (AsyncWebParameter* p : _params) {
+		delete p;
+	}
+	delete _response;
+	if (_tempObject != nullptr) {
+		free(_tempObject);
+	}
+}
+
+const char * AsyncWebServerRequest::methodToString() const {
+	if (_method == HTTP_ANY) return "ANY";
+	else if (_method & HTTP_GET) return "GET";
+	else if (_method & HTTP_POST) return "POST";
+	else if (_method & HTTP_DELETE) return "DELETE";
+	else if (_method & HTTP_PUT) return "PUT";
+	else if (_method & HTTP_PATCH) return "PATCH";
+	else if (_method & HTTP_HEAD) return "HEAD";
+	else if (_method & HTTP_OPTIONS) return "OPTIONS";
+	return "UNKNOWN";
+}
+
+void AsyncWebServerRequest::redirect(const String& url) {
+	AsyncWebServerResponse * response = beginResponse(302);
+	response->addHeader("Location", url);
+	send(response);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+	delete _response;
+	_response = response;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+	send(beginResponse(code, contentType, content));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& contentType, const uint8_t * content, size_t len) {
+	send(beginResponse_P(code, contentType, content, len));
+}
+
+void AsyncWebServerRequest::send_P(int code, const String& contentType, PGM_P content) {
+	send(beginResponse_P(code, contentType, content));
+}
+
+void AsyncWebServerRequest::sendChunked(const String& contentType, AwsResponseFiller callback) {
+	send(beginChunkedResponse(contentType, callback));
+}
+
+AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content) {
+	return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(const String& contentType, size_t len, AwsResponseFiller callback) {
+	return new AsyncCallbackResponse(contentType, len, callback);
+}
+
+AsyncWebServerResponse * AsyncWebServerRequest::beginChunkedResponse(const String& contentType, AwsResponseFiller callback) {
+	return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream * AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize) {
+	return new AsyncResponseStream(contentType, bufferSize);
+}
+
+AsyncWebServerResponse * AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, const uint8_t * content, size_t len) {
+	return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse * AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, PGM_P content) {
+	return beginResponse_P(code, contentType, (const uint8_t *) content, strlen_P(content));
+}
+
+bool AsyncWebServerRequest::hasHeader(const String& name) const {
+	return (getHeader(name) != nullptr);
+}
+
+const AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+	for (const AsyncWebHeader& h : _headers) {
+		if (h.name().equalsIgnoreCase(name)) {
+			return &h;
+		}
+	}
+	return nullptr;
+}
+
+bool AsyncWebServerRequest::hasParam(const String& name, bool post, bool file) const {
+	return (getParam(name, post, file) != nullptr);
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+	for (AsyncWebParameter* p : _params) {
+		if ((p->name() == name) && (p->isPost() == post) && (p->isFile() == file)) {
+			return p;
+		}
+	}
+	return nullptr;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(size_t num) const {
+	return (num < _params.size() ? _params[num] : nullptr);
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+	for (AsyncWebParameter* p : _params) {
+		if (p->name() == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+	for (AsyncWebParameter* p : _params) {
+		if (p->name() == name) {
+			return p->value();
+		}
+	}
+	return emptyString;
+}
+
+void AsyncWebServerRequest::_setRequestLine(WebRequestMethodComposite method, const String& target) {
+	_method = method;
+	int q = target.indexOf('?');
+	if (q < 0) {
+		_url = _urlDecode(target.c_str(), target.length());
+	} else {
+		_url = _urlDecode(target.c_str(), q);
+		_parseQuery(target.c_str() + q + 1, target.length() - q - 1, false);
+	}
+}
+
+void AsyncWebServerRequest::_addHeader(const String& name, const String& value) {
+	if (name.equalsIgnoreCase("Host")) {
+		_host = value;
+	} else if (name.equalsIgnoreCase("Content-Type")) {
+		int semicolon = value.indexOf(';');
+		_contentType = (semicolon < 0 ? value : value.substring(0, semicolon));
+		if (value.startsWith("multipart/")) {
+			_boundary = value.substring(value.indexOf('=') + 1);
+			_boundary.replace("\"", "");
+			_isMultipart = true;
+		}
+	} else if (name.equalsIgnoreCase("Content-Length")) {
+		_contentLength = atoi(value.c_str());
+	}
+	_headers.push_back(AsyncWebHeader(name, value));
+}
+
+void AsyncWebServerRequest::_parseQuery(const char* query, size_t length, bool post) {
+	size_t start = 0;
+	while (start < length) {
+		const char* amp = (const char*) memchr(query + start, '&', length - start);
+		size_t end = (amp != nullptr ? amp - query : length);
+		const char* eq = (const char*) memchr(query + start, '=', end - start);
+		if (end > start) {
+			if (eq != nullptr) {
+				size_t nameEnd = eq - query;
+				_params.push_back(new AsyncWebParameter(_urlDecode(query + start, nameEnd - start),
+						_urlDecode(eq + 1, end - nameEnd - 1), post));
+			} else {
+				_params.push_back(new AsyncWebParameter(_urlDecode(query + start, end - start), String(), post));
+			}
+		}
+		start = end + 1;
+	}
+}
+
+String AsyncWebServerRequest::_urlDecode(const char* text, size_t length) {
+	String decoded;
+	decoded.reserve(length);
+	for (size_t i = 0; i < length; i++) {
+		char c = text[i];
+		if ((c == '%') && (i + 2 < length)) {
+			char hex[3] = { text[i + 1], text[i + 2], '\0' };
+			decoded += (char) strtol(hex, nullptr, 16);
+			i += 2;
+		} else if (c == '+') {
+			decoded += ' ';
+		} else {
+			decoded += c;
+		}
+	}
+	return decoded;
+}
+
+void AsyncWebServerRequest::_headersEnd() {
+	_server->_attachHandler(this);
+	if (_contentLength == 0) {
+		_end();
+	}
+}
+
+static bool isParamChar(char c) {
+	return ((c) && ((c) != '{') && ((c) != '[') && ((c) != '&') && ((c) != '='));
+}
+
+void AsyncWebServerRequest::_parseBody(const uint8_t* data, size_t len) {
+	if ((len == 0) || (_parsedLength >= _contentLength)) {
+		return;
+	}
+	len = std::min(len, _contentLength - _parsedLength);
+	// If the handler does nothing, the body doesn't need to be parsed
+	bool needParse = ((_handler != nullptr) && (!_handler->isRequestHandlerTrivial()));
+	if (_isMultipart) {
+		if (needParse) {
+			_multipartBuffer.insert(_multipartBuffer.end(), data, data + len);
+		}
+	} else {
+		if (_parsedLength == 0) {
+			if (_contentType.startsWith("application/x-www-form-urlencoded")) {
+				_isPlainPost = true;
+			} else if ((_contentType == "text/plain") && (isParamChar(data[0]))) {
+				size_t i = 0;
+				while ((i < len) && (isParamChar(data[i++])));
+				if ((i < len) && (data[i - 1] == '=')) {
+					_isPlainPost = true;
+				}
+			}
+		}
+		if (!_isPlainPost) {
+			if (_handler != nullptr) {
+				_handler->handleBody(this, (uint8_t*) data, len, _parsedLength, _contentLength);
+			}
+		} else if (needParse) {
+			_plainPostBuffer.concat((const char*) data, len);
+		}
+	}
+	_parsedLength += len;
+	if (_parsedLength == _contentLength) {
+		_end();
+	}
+}
+
+void AsyncWebServerRequest::_parseMultipart() {
+	String delimiter = "--" + _boundary;
+	const uint8_t* body = _multipartBuffer.data();
+	size_t size = _multipartBuffer.size();
+	const uint8_t* pos = (const uint8_t*) memmem(body, size, delimiter.c_str(), delimiter.length());
+	while (pos != nullptr) {
+		pos += delimiter.length();
+		size_t remaining = size - (pos - body);
+		if ((remaining < 2) || (memcmp(pos, "--", 2) == 0)) {
+			break;
+		}
+		const uint8_t* headerEnd = (const uint8_t*) memmem(pos, remaining, "\r\n\r\n", 4);
+		if (headerEnd == nullptr) {
+			break;
+		}
+		String partHeaders((const char*) pos, headerEnd - pos);
+		String name, filename;
+		int n = partHeaders.indexOf("name=\"");
+		if (n >= 0) {
+			name = partHeaders.substring(n + 6, partHeaders.indexOf('"', n + 6));
+		}
+		int f = partHeaders.indexOf("filename=\"");
+		if (f >= 0) {
+			filename = partHeaders.substring(f + 10, partHeaders.indexOf('"', f + 10));
+		}
+		const uint8_t* content = headerEnd + 4;
+		String endDelimiter = "\r\n" + delimiter;
+		const uint8_t* next = (const uint8_t*) memmem(content, size - (content - body), endDelimiter.c_str(), endDelimiter.length());
+		if (next == nullptr) {
+			break;
+		}
+		size_t contentSize = next - content;
+		if (f >= 0) {
+			size_t index = 0;
+			do {
+				size_t chunk = std::min(contentSize - index, (size_t) ASYNC_HOST_SEGMENT_SIZE);
+				_handler->handleUpload(this, filename, index, (uint8_t*) content + index, chunk, index + chunk == contentSize);
+				index += chunk;
+			} while (index < contentSize);
+			_params.push_back(new AsyncWebParameter(name, filename, true, true, contentSize));
+		} else {
+			_params.push_back(new AsyncWebParameter(name, String((const char*) content, contentSize), true));
+		}
+		pos = next + 2;
+	}
+	_multipartBuffer.clear();
+}
+
+void AsyncWebServerRequest::_end() {
+	if (_isPlainPost) {
+		_parseQuery(_plainPostBuffer.c_str(), _plainPostBuffer.length(), true);
+		_plainPostBuffer = String();
+	} else if ((_isMultipart) && (!_multipartBuffer.empty())) {
+		_parseMultipart();
+	}
+	if (_handler != nullptr) {
+		_handler->handleRequest(this);
+	} else {
+		send(501);
+	}
+}
+
+/*
+ * Responses
+ */
+
+AsyncWebServerResponse::AsyncWebServerResponse()
+	: _code(0), _contentLength(0), _sendContentLength(true), _chunked(false) {
+}
+
+AsyncWebServerResponse::~AsyncWebServerResponse() {
+}
+
+void AsyncWebServerResponse::addHeader(const String& name, const String& value) {
+	_headers.push_back(AsyncWebHeader(name, value));
+}
+
+const char* AsyncWebServerResponse::_responseCodeToString(int code) {
+	switch (code) {
+	case 100: return "Continue";
+	case 200: return "OK";
+	case 201: return "Created";
+	case 202: return "Accepted";
+	case 204: return "No Content";
+	case 301: return "Moved Permanently";
+	case 302: return "Found";
+	case 304: return "Not Modified";
+	case 400: return "Bad Request";
+	case 401: return "Unauthorized";
+	case 403: return "Forbidden";
+	case 404: return "Not Found";
+	case 405: return "Method Not Allowed";
+	case 413: return "Request Entity Too Large";
+	case 422: return "Unprocessable Entity";
+	case 500: return "Internal Server Error";
+	case 501: return "Not Implemented";
+	case 503: return "Service Unavailable";
+	default: return "";
+	}
+}
+
+size_t AsyncWebServerResponse::_write(Print* out, AsyncClient* client) {
+	String head = "HTTP/1.1 ";
+	head.concat(_code);
+	head.concat(' ');
+	head.concat(_responseCodeToString(_code));
+	head.concat("\r\n");
+	if (_chunked) {
+		head.concat("Transfer-Encoding: chunked\r\n");
+	} else if (_sendContentLength) {
+		head.concat("Content-Length: ");
+		head.concat((unsigned long) _contentLength);
+		head.concat("\r\n");
+	}
+	if (_contentType.length()) {
+		head.concat("Content-Type: ");
+		head.concat(_contentType);
+		head.concat("\r\n");
+	}
+	for (const AsyncWebHeader& h : _headers) {
+		head.concat(h.name());
+		head.concat(": ");
+		head.concat(h.value());
+		head.concat("\r\n");
+	}
+	head.concat("Connection: close\r\n\r\n");
+	size_t written = out->write((const uint8_t*) head.c_str(), head.length());
+	uint8_t buf[ASYNC_HOST_SEGMENT_SIZE];
+	size_t bodyWritten = 0;
+	while (true) {
+		size_t limit = ASYNC_HOST_SEGMENT_SIZE;
+		if (_chunked) {
+			// room for the chunk size line and the trailing CRLF
+			limit -= 8;
+		} else if (_sendContentLength) {
+			if (bodyWritten >= _contentLength) {
+				break;
+			}
+			limit = std::min(limit, _contentLength - bodyWritten);
+		}
+		size_t n = _fillBuffer(buf, limit);
+		if (n == RESPONSE_TRY_AGAIN) {
+			yield();
+			continue;
+		}
+		if ((client != nullptr) && (!client->connected())) {
+			// closed by the filler, the connection drops without the rest of the body
+			break;
+		}
+		if (_chunked) {
+			char sizeLine[12];
+			int l = snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", (unsigned int) n);
+			written += out->write((const uint8_t*) sizeLine, l);
+			written += out->write(buf, n);
+			written += out->write((const uint8_t*) "\r\n", 2);
+		} else {
+			written += out->write(buf, n);
+		}
+		if (n == 0) {
+			break;
+		}
+		bodyWritten += n;
+	}
+	return written;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const String& content)
+	: _content(content), _sent(0) {
+	_code = code;
+	_contentType = contentType;
+	if (_content.length()) {
+		_contentLength = _content.length();
+		if (!_contentType.length()) {
+			_contentType = "text/plain";
+		}
+	}
+}
+
+size_t AsyncBasicResponse::_fillBuffer(uint8_t *buf, size_t maxLen) {
+	size_t n = std::min(maxLen, (size_t) _content.length() - _sent);
+	memcpy(buf, _content.c_str() + _sent, n);
+	_sent += n;
+	return n;
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String& contentType, const uint8_t * content, size_t len)
+	: _content(content), _sent(0) {
+	_code = code;
+	_contentType = contentType;
+	_contentLength = len;
+}
+
+size_t AsyncProgmemResponse::_fillBuffer(uint8_t *buf, size_t maxLen) {
+	size_t n = std::min(maxLen, _contentLength - _sent);
+	memcpy_P(buf, _content + _sent, n);
+	_sent += n;
+	return n;
+}
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller callback)
+	: _content(callback), _filledLength(0) {
+	_code = 200;
+	_contentLength = len;
+	if (len == 0) {
+		_sendContentLength = false;
+	}
+	_contentType = contentType;
+}
+
+size_t AsyncCallbackResponse::_fillBuffer(uint8_t *buf, size_t maxLen) {
+	size_t ret = _content(buf, maxLen, _filledLength);
+	if (ret != RESPONSE_TRY_AGAIN) {
+		_filledLength += ret;
+	}
+	return ret;
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback)
+	: AsyncCallbackResponse(contentType, 0, callback) {
+	_sendContentLength = false;
+	_chunked = true;
+}
+
+AsyncResponseStream::AsyncResponseStream(const String& contentType, size_t bufferSize)
+	: _capacity(bufferSize), _sent(0) {
+	_code = 200;
+	_contentType = contentType;
+	_content = new uint8_t[bufferSize];
+}
+
+AsyncResponseStream::~AsyncResponseStream() {
+	delete[] _content;
+}
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t len) {
+	// like cbuf, one byte of the buffer stays unused
+	if (len + 1 > _capacity - _contentLength) {
+		// grows by exactly what is missing, like cbuf::resizeAdd
+		size_t newCapacity = _contentLength + len + 1;
+		uint8_t* resized = new uint8_t[newCapacity];
+		memcpy(resized, _content, _contentLength);
+		delete[] _content;
+		_content = resized;
+		_capacity = newCapacity;
+	}
+	memcpy(_content + _contentLength, data, len);
+	_contentLength += len;
+	return len;
+}
+
+size_t AsyncResponseStream::write(uint8_t data) {
+	return write(&data, 1);
+}
+
+size_t AsyncResponseStream::_fillBuffer(uint8_t *buf, size_t maxLen) {
+	size_t n = std::min(maxLen, _contentLength - _sent);
+	memcpy(buf, _content + _sent, n);
+	_sent += n;
+	return n;
+}
+
+/*
+ * Handlers
+ */
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) {
+	if (!_onRequest) {
+		return false;
+	}
+	if (!(_method & request->method())) {
+		return false;
+	}
+	if ((_uri.length()) && (_uri.endsWith("*"))) {
+		String uriTemplate = String(_uri);
+		uriTemplate = uriTemplate.substring(0, uriTemplate.length() - 1);
+		if (!request->url().startsWith(uriTemplate)) {
+			return false;
+		}
+	} else if ((_uri.length()) && (_uri != request->url()) && (!request->url().startsWith(_uri + "/"))) {
+		return false;
+	}
+	return true;
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request) {
+	if (_onRequest) {
+		_onRequest(request);
+	} else {
+		request->send(500);
+	}
+}
+
+void AsyncCallbackWebHandler::handleUpload(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+	if (_onUpload) {
+		_onUpload(request, filename, index, data, len, final);
+	}
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+	if (_onBody) {
+		_onBody(request, data, len, index, total);
+	}
+}
+
+/*
+ * AsyncWebServer
+ */
+
+AsyncWebServer::AsyncWebServer(uint16_t port) : _port(port), _fd(-1) {
+	_catchAllHandler = new AsyncCallbackWebHandler();
+}
+
+AsyncWebServer::~AsyncWebServer() {
+	reset();
+	end();
+	delete _catchAllHandler;
+}
+
+void AsyncWebServer::begin() {
+	if (_fd >= 0) {
+		return;
+	}
+	_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_fd < 0) {
+		return;
+	}
+	int one = 1;
+	setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(_port);
+	if ((bind(_fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) || (listen(_fd, 8) < 0)) {
+		fprintf(stderr, "AsyncWebServer: can't listen on port %u: %s\n", _port, strerror(errno));
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+void AsyncWebServer::end() {
+	if (_fd >= 0) {
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+void AsyncWebServer::reset() {
+	for (AsyncWebHandler* h : _handlers) {
+		delete h;
+	}
+	_handlers.clear();
+	_catchAllHandler->onRequest(nullptr);
+	_catchAllHandler->onUpload(nullptr);
+	_catchAllHandler->onBody(nullptr);
+}
+
+AsyncWebHandler& AsyncWebServer::addHandler(AsyncWebHandler* handler) {
+	_handlers.push_back(handler);
+	return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler* handler) {
+	for (auto it = _handlers.begin(); it != _handlers.end(); ++it) {
+		if (*it == handler) {
+			_handlers.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, ArRequestHandlerFunction onRequest) {
+	return on(uri, HTTP_ANY, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+	return on(uri, method, onRequest, nullptr, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload) {
+	return on(uri, method, onRequest, onUpload, nullptr);
+}
+
+AsyncCallbackWebHandler& AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+	AsyncCallbackWebHandler* handler = new AsyncCallbackWebHandler();
+	handler->setUri(uri);
+	handler->setMethod(method);
+	handler->onRequest(onRequest);
+	handler->onUpload(onUpload);
+	handler->onBody(onBody);
+	addHandler(handler);
+	return *handler;
+}
+
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction fn) {
+	_catchAllHandler->onRequest(fn);
+}
+
+void AsyncWebServer::onFileUpload(ArUploadHandlerFunction fn) {
+	_catchAllHandler->onUpload(fn);
+}
+
+void AsyncWebServer::onRequestBody(ArBodyHandlerFunction fn) {
+	_catchAllHandler->onBody(fn);
+}
+
+void AsyncWebServer::_attachHandler(AsyncWebServerRequest *request) {
+	for (AsyncWebHandler* h : _handlers) {
+		if (h->canHandle(request)) {
+			request->_handler = h;
+			return;
+		}
+	}
+	request->_handler = _catchAllHandler;
+}
+
+/*
+ * Request of a connection. As in ESPAsyncWebServer, the request is deleted
+ * by the disconnect callback of its client, also when a handler closes the
+ * client at once.
+ */
+static AsyncWebServerRequest* newRequest(AsyncWebServer* server, AsyncClient* client) {
+	AsyncWebServerRequest* request = new AsyncWebServerRequest(server, client);
+	client->onDisconnect([](void* r, AsyncClient* c) {
+		delete (AsyncWebServerRequest*) r;
+	}, request);
+	return request;
+}
+
+// ends the connection when it goes out of scope
+class ConnectionScope {
+public:
+	ConnectionScope(AsyncClient* client) : client(client) {
+	}
+	~ConnectionScope() {
+		client->_discard();
+	}
+private:
+	AsyncClient* client;
+};
+
+int AsyncWebServer::handleRequest(WebRequestMethodComposite method, const char* url,
+		const uint8_t* body, size_t bodyLength, const char* contentType, Print* out) {
+	AsyncClient client;
+	AsyncWebServerRequest* request = newRequest(this, &client);
+	ConnectionScope scope(&client);
+	request->_setRequestLine(method, url);
+	if (contentType != nullptr) {
+		request->_addHeader("Content-Type", contentType);
+	}
+	request->_contentLength = bodyLength;
+	request->_headersEnd();
+	for (size_t index = 0; index < bodyLength; index += ASYNC_HOST_SEGMENT_SIZE) {
+		request->_parseBody(body + index, std::min(bodyLength - index, (size_t) ASYNC_HOST_SEGMENT_SIZE));
+	}
+	if (request->_response == nullptr) {
+		return 0;
+	}
+	if (out != nullptr) {
+		request->_response->_write(out, &client);
+	}
+	return request->_response->code();
+}
+
+class SocketPrint: public Print {
+public:
+	SocketPrint(int fd) : fd(fd) {
+	}
+	size_t write(uint8_t c) override {
+		return write(&c, 1);
+	}
+	size_t write(const uint8_t *buffer, size_t size) override {
+		size_t sent = 0;
+		while (sent < size) {
+			ssize_t n = ::send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+			if (n <= 0) {
+				break;
+			}
+			sent += n;
+		}
+		return sent;
+	}
+private:
+	int fd;
+};
+
+static WebRequestMethodComposite methodFromString(const String& method) {
+	if (method == "GET") return HTTP_GET;
+	if (method == "POST") return HTTP_POST;
+	if (method == "DELETE") return HTTP_DELETE;
+	if (method == "PUT") return HTTP_PUT;
+	if (method == "PATCH") return HTTP_PATCH;
+	if (method == "HEAD") return HTTP_HEAD;
+	if (method == "OPTIONS") return HTTP_OPTIONS;
+	return 0;
+}
+
+void AsyncWebServer::handleClient() {
+	if (_fd < 0) {
+		return;
+	}
+	while (true) {
+		int clientFd = accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC);
+		if (clientFd < 0) {
+			return;
+		}
+		_serve(clientFd);
+		::close(clientFd);
+	}
+}
+
+void AsyncWebServer::_serve(int clientFd) {
+	struct timeval timeout = { 2, 0 };
+	setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	struct sockaddr_in peer;
+	socklen_t peerLength = sizeof(peer);
+	AsyncClient client;
+	if (getpeername(clientFd, (struct sockaddr*) &peer, &peerLength) == 0) {
+		client = AsyncClient(IPAddress(peer.sin_addr.s_addr), ntohs(peer.sin_port));
+	}
+	// read up to the end of the header block
+	uint8_t buf[ASYNC_HOST_SEGMENT_SIZE];
+	std::vector<uint8_t> head;
+	const uint8_t* headEnd = nullptr;
+	while (headEnd == nullptr) {
+		ssize_t n = recv(clientFd, buf, sizeof(buf), 0);
+		if (n <= 0) {
+			return;
+		}
+		head.insert(head.end(), buf, buf + n);
+		headEnd = (const uint8_t*) memmem(head.data(), head.size(), "\r\n\r\n", 4);
+		if ((headEnd == nullptr) && (head.size() > 8192)) {
+			return;
+		}
+	}
+	size_t headLength = (headEnd - head.data()) + 4;
+	String headers((const char*) head.data(), headLength);
+	AsyncWebServerRequest* request = newRequest(this, &client);
+	ConnectionScope scope(&client);
+	int lineEnd = headers.indexOf("\r\n");
+	String requestLine = headers.substring(0, lineEnd);
+	int s1 = requestLine.indexOf(' ');
+	int s2 = requestLine.indexOf(' ', s1 + 1);
+	WebRequestMethodComposite method = methodFromString(requestLine.substring(0, s1));
+	if ((s1 < 0) || (s2 < 0) || (method == 0)) {
+		SocketPrint out(clientFd);
+		AsyncBasicResponse(400)._write(&out);
+		return;
+	}
+	request->_setRequestLine(method, requestLine.substring(s1 + 1, s2));
+	int lineStart = lineEnd + 2;
+	while ((lineEnd = headers.indexOf("\r\n", lineStart)) > lineStart) {
+		String line = headers.substring(lineStart, lineEnd);
+		int colon = line.indexOf(':');
+		if (colon > 0) {
+			String value = line.substring(colon + 1);
+			value.trim();
+			request->_addHeader(line.substring(0, colon), value);
+		}
+		lineStart = lineEnd + 2;
+	}
+	request->_headersEnd();
+	// body bytes are handed on as they come in from the socket
+	if (head.size() > headLength) {
+		request->_parseBody(head.data() + headLength, head.size() - headLength);
+	}
+	while (request->_parsedLength < request->_contentLength) {
+		ssize_t n = recv(clientFd, buf, sizeof(buf), 0);
+		if (n <= 0) {
+			return;
+		}
+		request->_parseBody(buf, n);
+	}
+	if (request->_response != nullptr) {
+		SocketPrint out(clientFd);
+		request->_response->_write(&out, &client);
+	}
+}
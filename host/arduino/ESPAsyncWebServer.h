@@ -0,0 +1,374 @@
+#ifndef HOST_ESPASYNCWEBSERVER_H
+#define HOST_ESPASYNCWEBSERVER_H
+
+/*
+ * Host stand-in for ESPAsyncWebServer. Handler registration, handler
+ * matching, body delivery and the response classes follow the library;
+ * the transport is a single-threaded loop over a listening socket that the
+ * host application drives with AsyncWebServer::handleClient().
+ * AsyncWebServer::handleRequest() runs a request through the same path
+ * without a socket, for benchmarks.
+ */
+
+#include "Arduino.h"
+#include "ESPAsyncTCP.h"
+#include <vector>
+
+typedef enum {
+	HTTP_GET = 0b00000001,
+	HTTP_POST = 0b00000010,
+	HTTP_DELETE = 0b00000100,
+	HTTP_PUT = 0b00001000,
+	HTTP_PATCH = 0b00010000,
+	HTTP_HEAD = 0b00100000,
+	HTTP_OPTIONS = 0b01000000,
+	HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+// filler callbacks may return this when they have nothing to send yet
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+
+// largest piece of a body or response the host transport moves at once (one TCP segment)
+#define ASYNC_HOST_SEGMENT_SIZE 1460
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncResponseStream;
+class AsyncWebHandler;
+
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebParameter {
+public:
+	AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false, size_t size = 0)
+		: _name(name), _value(value), _size(size), _isForm(form), _isFile(file) {
+	}
+	const String& name() const {
+		return _name;
+	}
+	const String& value() const {
+		return _value;
+	}
+	size_t size() const {
+		return _size;
+	}
+	bool isPost() const {
+		return _isForm;
+	}
+	bool isFile() const {
+		return _isFile;
+	}
+
+private:
+	String _name;
+	String _value;
+	size_t _size;
+	bool _isForm;
+	bool _isFile;
+};
+
+class AsyncWebHeader {
+public:
+	AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {
+	}
+	const String& name() const {
+		return _name;
+	}
+	const String& value() const {
+		return _value;
+	}
+
+private:
+	String _name;
+	String _value;
+};
+
+class AsyncWebServerRequest {
+	friend class AsyncWebServer;
+public:
+	AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client);
+	~AsyncWebServerRequest();
+
+	void *_tempObject;
+
+	// called when the connection goes, before the request is deleted
+	void onDisconnect(ArDisconnectHandler fn) {
+		_onDisconnectfn = fn;
+	}
+
+	AsyncClient* client() {
+		return _client;
+	}
+	uint8_t version() const {
+		return 1;
+	}
+	WebRequestMethodComposite method() const {
+		return _method;
+	}
+	const String& url() const {
+		return _url;
+	}
+	const String& host() const {
+		return _host;
+	}
+	const String& contentType() const {
+		return _contentType;
+	}
+	size_t contentLength() const {
+		return _contentLength;
+	}
+	bool multipart() const {
+		return _isMultipart;
+	}
+	const char * methodToString() const;
+
+	void redirect(const String& url);
+
+	void send(AsyncWebServerResponse *response);
+	void send(int code, const String& contentType = String(), const String& content = String());
+	void send_P(int code, const String& contentType, const uint8_t * content, size_t len);
+	void send_P(int code, const String& contentType, PGM_P content);
+	void sendChunked(const String& contentType, AwsResponseFiller callback);
+
+	AsyncWebServerResponse *beginResponse(int code, const String& contentType = String(), const String& content = String());
+	AsyncWebServerResponse *beginResponse(const String& contentType, size_t len, AwsResponseFiller callback);
+	AsyncWebServerResponse *beginChunkedResponse(const String& contentType, AwsResponseFiller callback);
+	AsyncResponseStream *beginResponseStream(const String& contentType, size_t bufferSize = 1460);
+	AsyncWebServerResponse *beginResponse_P(int code, const String& contentType, const uint8_t * content, size_t len);
+	AsyncWebServerResponse *beginResponse_P(int code, const String& contentType, PGM_P content);
+
+	size_t headers() const {
+		return _headers.size();
+	}
+	bool hasHeader(const String& name) const;
+	const AsyncWebHeader* getHeader(const String& name) const;
+
+	size_t params() const {
+		return _params.size();
+	}
+	bool hasParam(const String& name, bool post = false, bool file = false) const;
+	AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+	AsyncWebParameter* getParam(size_t num) const;
+	bool hasArg(const char* name) const;
+	const String& arg(const String& name) const;
+
+private:
+	AsyncWebServer* _server;
+	AsyncClient* _client;
+	AsyncWebHandler* _handler;
+	AsyncWebServerResponse* _response;
+	WebRequestMethodComposite _method;
+	String _url;
+	String _host;
+	String _contentType;
+	String _boundary;
+	size_t _contentLength;
+	size_t _parsedLength;
+	bool _isMultipart;
+	bool _isPlainPost;
+	String _plainPostBuffer;
+	std::vector<uint8_t> _multipartBuffer;
+	std::vector<AsyncWebHeader> _headers;
+	std::vector<AsyncWebParameter*> _params;
+	ArDisconnectHandler _onDisconnectfn;
+
+	void _setRequestLine(WebRequestMethodComposite method, const String& target);
+	void _addHeader(const String& name, const String& value);
+	void _parseQuery(const char* query, size_t length, bool post);
+	void _headersEnd();
+	void _parseBody(const uint8_t* data, size_t len);
+	void _end();
+	void _parseMultipart();
+	static String _urlDecode(const char* text, size_t length);
+};
+
+class AsyncWebServerResponse {
+public:
+	AsyncWebServerResponse();
+	virtual ~AsyncWebServerResponse();
+	virtual void setCode(int code) {
+		_code = code;
+	}
+	virtual void setContentLength(size_t len) {
+		_contentLength = len;
+	}
+	virtual void setContentType(const String& type) {
+		_contentType = type;
+	}
+	virtual void addHeader(const String& name, const String& value);
+	int code() const {
+		return _code;
+	}
+
+	/* Host only: writes status line, headers and body to the connection. */
+	size_t _write(Print* out, AsyncClient* client = nullptr);
+
+protected:
+	int _code;
+	std::vector<AsyncWebHeader> _headers;
+	String _contentType;
+	size_t _contentLength;
+	bool _sendContentLength;
+	bool _chunked;
+
+	// fills buf with the next part of the body, returns 0 at the end
+	virtual size_t _fillBuffer(uint8_t *buf, size_t maxLen) {
+		return 0;
+	}
+	static const char* _responseCodeToString(int code);
+};
+
+class AsyncBasicResponse: public AsyncWebServerResponse {
+public:
+	AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String());
+protected:
+	size_t _fillBuffer(uint8_t *buf, size_t maxLen) override;
+private:
+	String _content;
+	size_t _sent;
+};
+
+class AsyncProgmemResponse: public AsyncWebServerResponse {
+public:
+	AsyncProgmemResponse(int code, const String& contentType, const uint8_t * content, size_t len);
+protected:
+	size_t _fillBuffer(uint8_t *buf, size_t maxLen) override;
+private:
+	const uint8_t * _content;
+	size_t _sent;
+};
+
+class AsyncCallbackResponse: public AsyncWebServerResponse {
+public:
+	AsyncCallbackResponse(const String& contentType, size_t len, AwsResponseFiller callback);
+protected:
+	size_t _fillBuffer(uint8_t *buf, size_t maxLen) override;
+	AwsResponseFiller _content;
+	size_t _filledLength;
+};
+
+class AsyncChunkedResponse: public AsyncCallbackResponse {
+public:
+	AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback);
+};
+
+class AsyncResponseStream: public AsyncWebServerResponse, public Print {
+public:
+	AsyncResponseStream(const String& contentType, size_t bufferSize);
+	~AsyncResponseStream();
+	size_t write(const uint8_t *data, size_t len) override;
+	size_t write(uint8_t data) override;
+	using Print::write;
+protected:
+	size_t _fillBuffer(uint8_t *buf, size_t maxLen) override;
+private:
+	uint8_t* _content;
+	size_t _capacity;
+	size_t _sent;
+};
+
+class AsyncWebHandler {
+public:
+	virtual ~AsyncWebHandler() {
+	}
+	virtual bool canHandle(AsyncWebServerRequest *request) {
+		return false;
+	}
+	virtual void handleRequest(AsyncWebServerRequest *request) {
+	}
+	virtual void handleUpload(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+	}
+	virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+	}
+	virtual bool isRequestHandlerTrivial() {
+		return true;
+	}
+};
+
+class AsyncCallbackWebHandler: public AsyncWebHandler {
+public:
+	AsyncCallbackWebHandler() : _uri(), _method(HTTP_ANY), _onRequest(nullptr), _onUpload(nullptr), _onBody(nullptr) {
+	}
+	void setUri(const String& uri) {
+		_uri = uri;
+	}
+	void setMethod(WebRequestMethodComposite method) {
+		_method = method;
+	}
+	void onRequest(ArRequestHandlerFunction fn) {
+		_onRequest = fn;
+	}
+	void onUpload(ArUploadHandlerFunction fn) {
+		_onUpload = fn;
+	}
+	void onBody(ArBodyHandlerFunction fn) {
+		_onBody = fn;
+	}
+
+	bool canHandle(AsyncWebServerRequest *request) override;
+	void handleRequest(AsyncWebServerRequest *request) override;
+	void handleUpload(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) override;
+	void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+	bool isRequestHandlerTrivial() override {
+		return (_onRequest ? false : true);
+	}
+
+private:
+	String _uri;
+	WebRequestMethodComposite _method;
+	ArRequestHandlerFunction _onRequest;
+	ArUploadHandlerFunction _onUpload;
+	ArBodyHandlerFunction _onBody;
+};
+
+class AsyncWebServer {
+	friend class AsyncWebServerRequest;
+public:
+	AsyncWebServer(uint16_t port);
+	~AsyncWebServer();
+
+	void begin();
+	void end();
+	void reset();
+
+	AsyncWebHandler& addHandler(AsyncWebHandler* handler);
+	bool removeHandler(AsyncWebHandler* handler);
+
+	AsyncCallbackWebHandler& on(const char* uri, ArRequestHandlerFunction onRequest);
+	AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+	AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload);
+	AsyncCallbackWebHandler& on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody);
+
+	void onNotFound(ArRequestHandlerFunction fn);
+	void onFileUpload(ArUploadHandlerFunction fn);
+	void onRequestBody(ArBodyHandlerFunction fn);
+
+	/* Host only: serves all connections waiting on the listening socket. */
+	void handleClient();
+
+	/*
+	 * Host only: runs one request through the handlers without a socket and
+	 * writes the raw HTTP response to out (if not null). Returns the status code.
+	 */
+	int handleRequest(WebRequestMethodComposite method, const char* url,
+			const uint8_t* body = nullptr, size_t bodyLength = 0,
+			const char* contentType = nullptr, Print* out = nullptr);
+
+private:
+	uint16_t _port;
+	int _fd;
+	std::vector<AsyncWebHandler*> _handlers;
+	AsyncCallbackWebHandler* _catchAllHandler;
+
+	void _attachHandler(AsyncWebServerRequest *request);
+	void _serve(int clientFd);
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HOST_ESP_H
+#define HOST_ESP_H
+
+#include <stdint.h>
+
+/*
+ * Host stand-in for the ESP object. Heap figures are fixed values that can be
+ * changed by a harness (e.g. to provoke the 503 path in checkAndLogWebAccess).
+ */
+class EspClass {
+public:
+	uint32_t getMaxFreeBlockSize() {
+		return maxFreeBlockSize;
+	}
+	uint32_t getFreeHeap() {
+		return freeHeap;
+	}
+	uint8_t getHeapFragmentation() {
+		return (freeHeap ? 100 - (uint32_t) (100ULL * maxFreeBlockSize / freeHeap) : 0);
+	}
+	uint32_t getChipId() {
+		return 0x00C0FFEE;
+	}
+	uint32_t getFlashChipId() {
+		return 0x001640EF;
+	}
+	uint32_t getFlashChipSize() {
+		return 4 * 1024 * 1024;
+	}
+	uint32_t getFlashChipRealSize() {
+		return 4 * 1024 * 1024;
+	}
+	uint32_t getSketchSize() {
+		return 512 * 1024;
+	}
+	uint32_t getFreeSketchSpace() {
+		return 1024 * 1024;
+	}
+	void restart();
+	void reset() {
+		restart();
+	}
+
+	uint32_t maxFreeBlockSize = 30 * 1024;
+	uint32_t freeHeap = 40 * 1024;
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HOST_HARDWARE_SERIAL_H
+#define HOST_HARDWARE_SERIAL_H
+
+#include "Stream.h"
+
+/*
+ * Host stand-in for the UART: output goes to stdout, input is read
+ * non-blocking from stdin.
+ */
+class HardwareSerial: public Stream {
+public:
+	void begin(unsigned long baud) {
+	}
+	void end() {
+	}
+
+	int available() override;
+	int read() override;
+	int peek() override;
+	void flush() override;
+
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+
+private:
+	int peeked = -1;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,34 @@
+#include "IPAddress.h"
+
+bool IPAddress::fromString(const char *address) {
+	uint16_t acc = 0;
+	uint8_t dots = 0;
+	while (*address) {
+		char c = *address++;
+		if (c >= '0' && c <= '9') {
+			acc = acc * 10 + (c - '0');
+			if (acc > 255) {
+				return false;
+			}
+		} else if (c == '.') {
+			if (dots == 3) {
+				return false;
+			}
+			this->address.bytes[dots++] = acc;
+			acc = 0;
+		} else {
+			return false;
+		}
+	}
+	if (dots != 3) {
+		return false;
+	}
+	this->address.bytes[3] = acc;
+	return true;
+}
+
+String IPAddress::toString() const {
+	char szRet[16];
+	snprintf(szRet, sizeof(szRet), "%u.%u.%u.%u", address.bytes[0], address.bytes[1], address.bytes[2], address.bytes[3]);
+	return String(szRet);
+}
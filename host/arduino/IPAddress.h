@@ -0,0 +1,52 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+	IPAddress() {
+		address.dword = 0;
+	}
+	IPAddress(uint8_t first_octet, uint8_t second_octet, uint8_t third_octet, uint8_t fourth_octet) {
+		address.bytes[0] = first_octet;
+		address.bytes[1] = second_octet;
+		address.bytes[2] = third_octet;
+		address.bytes[3] = fourth_octet;
+	}
+	IPAddress(uint32_t address) {
+		this->address.dword = address;
+	}
+
+	bool fromString(const char *address);
+	bool fromString(const String &address) {
+		return fromString(address.c_str());
+	}
+
+	operator uint32_t() const {
+		return address.dword;
+	}
+	bool operator==(const IPAddress& addr) const {
+		return address.dword == addr.address.dword;
+	}
+	uint8_t operator[](int index) const {
+		return address.bytes[index];
+	}
+	uint8_t& operator[](int index) {
+		return address.bytes[index];
+	}
+
+	bool isSet() const {
+		return (address.dword != 0);
+	}
+
+	String toString() const;
+
+private:
+	union {
+		uint8_t bytes[4];
+		uint32_t dword;
+	} address;
+};
+
+#endif
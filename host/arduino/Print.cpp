@@ -0,0 +1,216 @@
+#include "Arduino.h"
+#include <vector>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+	while (size--) {
+		size_t ret = write(*buffer++);
+		if (ret == 0) {
+			// Write of last byte didn't complete, abort additional processing
+			break;
+		}
+		n += ret;
+	}
+	return n;
+}
+
+size_t Print::vprintf(const char *format, va_list arg) {
+	char temp[64];
+	char* buffer = temp;
+	va_list copy;
+	va_copy(copy, arg);
+	size_t len = vsnprintf(temp, sizeof(temp), format, copy);
+	va_end(copy);
+	if (len > sizeof(temp) - 1) {
+		buffer = new char[len + 1];
+		vsnprintf(buffer, len + 1, format, arg);
+	}
+	len = write((const uint8_t*) buffer, len);
+	if (buffer != temp) {
+		delete[] buffer;
+	}
+	return len;
+}
+
+size_t Print::printf(const char *format, ...) {
+	va_list arg;
+	va_start(arg, format);
+	size_t len = vprintf(format, arg);
+	va_end(arg);
+	return len;
+}
+
+size_t Print::printf_P(PGM_P format, ...) {
+	va_list arg;
+	va_start(arg, format);
+	size_t len = vprintf(format, arg);
+	va_end(arg);
+	return len;
+}
+
+size_t Print::print(const __FlashStringHelper *ifsh) {
+	return write(reinterpret_cast<const char*>(ifsh));
+}
+
+size_t Print::print(const String &s) {
+	return write(s.c_str(), s.length());
+}
+
+size_t Print::print(const char str[]) {
+	return write(str);
+}
+
+size_t Print::print(char c) {
+	return write(c);
+}
+
+size_t Print::print(unsigned char b, int base) {
+	return print((unsigned long) b, base);
+}
+
+size_t Print::print(int n, int base) {
+	return print((long) n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+	return print((unsigned long) n, base);
+}
+
+size_t Print::print(long n, int base) {
+	return print((long long) n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+	return print((unsigned long long) n, base);
+}
+
+size_t Print::print(long long n, int base) {
+	if (base == 0) {
+		return write(n);
+	} else if (base == 10) {
+		if (n < 0) {
+			int t = print('-');
+			n = -n;
+			return printNumber(n, 10) + t;
+		}
+		return printNumber(n, 10);
+	} else {
+		return printNumber(n, base);
+	}
+}
+
+size_t Print::print(unsigned long long n, int base) {
+	if (base == 0) {
+		return write(n);
+	}
+	return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+	return printFloat(n, digits);
+}
+
+size_t Print::println(void) {
+	return print("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *ifsh) {
+	size_t n = print(ifsh);
+	n += println();
+	return n;
+}
+
+size_t Print::println(const String &s) {
+	size_t n = print(s);
+	n += println();
+	return n;
+}
+
+size_t Print::println(const char c[]) {
+	size_t n = print(c);
+	n += println();
+	return n;
+}
+
+size_t Print::println(char c) {
+	size_t n = print(c);
+	n += println();
+	return n;
+}
+
+size_t Print::println(unsigned char b, int base) {
+	size_t n = print(b, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(int num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(unsigned int num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(long num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(unsigned long num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(long long num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(unsigned long long num, int base) {
+	size_t n = print(num, base);
+	n += println();
+	return n;
+}
+
+size_t Print::println(double num, int digits) {
+	size_t n = print(num, digits);
+	n += println();
+	return n;
+}
+
+size_t Print::printNumber(unsigned long long n, uint8_t base) {
+	char buf[8 * sizeof(n) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+	*str = '\0';
+	// prevent crash if called with base == 1
+	if (base < 2) {
+		base = 10;
+	}
+	do {
+		unsigned long long m = n;
+		n /= base;
+		char c = m - base * n;
+		*--str = c < 10 ? c + '0' : c + 'A' - 10;
+	} while (n);
+	return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+	char buf[64];
+	int length = snprintf(buf, sizeof(buf), "%.*f", digits, number);
+	if (length < (int) sizeof(buf)) {
+		return write((const uint8_t*) buf, length);
+	}
+	// up to 309 integer digits for the largest doubles
+	std::vector<char> large(length + 1);
+	snprintf(large.data(), large.size(), "%.*f", digits, number);
+	return write((const uint8_t*) large.data(), length);
+}
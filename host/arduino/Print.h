@@ -0,0 +1,92 @@
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/*
+ * Host stand-in for the ESP8266 core Print class. As on the chip, only
+ * write(uint8_t) is pure and the default write(const uint8_t*, size_t)
+ * loops over it, so subclasses that only override the single byte write pay
+ * one virtual call per character.
+ */
+class Print {
+public:
+	Print() : write_error(0) {
+	}
+	virtual ~Print() {
+	}
+
+	int getWriteError() {
+		return write_error;
+	}
+	void clearWriteError() {
+		setWriteError(0);
+	}
+
+	virtual size_t write(uint8_t) = 0;
+	size_t write(const char *str) {
+		if (str == nullptr) {
+			return 0;
+		}
+		return write((const uint8_t *) str, strlen(str));
+	}
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *buffer, size_t size) {
+		return write((const uint8_t *) buffer, size);
+	}
+	virtual int availableForWrite() {
+		return 0;
+	}
+
+	size_t printf(const char *format, ...);
+	size_t printf_P(PGM_P format, ...);
+	size_t print(const __FlashStringHelper *);
+	size_t print(const String &);
+	size_t print(const char[]);
+	size_t print(char);
+	size_t print(unsigned char, int = DEC);
+	size_t print(int, int = DEC);
+	size_t print(unsigned int, int = DEC);
+	size_t print(long, int = DEC);
+	size_t print(unsigned long, int = DEC);
+	size_t print(long long, int = DEC);
+	size_t print(unsigned long long, int = DEC);
+	size_t print(double, int = 2);
+
+	size_t println(const __FlashStringHelper *);
+	size_t println(const String &s);
+	size_t println(const char[]);
+	size_t println(char);
+	size_t println(unsigned char, int = DEC);
+	size_t println(int, int = DEC);
+	size_t println(unsigned int, int = DEC);
+	size_t println(long, int = DEC);
+	size_t println(unsigned long, int = DEC);
+	size_t println(long long, int = DEC);
+	size_t println(unsigned long long, int = DEC);
+	size_t println(double, int = 2);
+	size_t println(void);
+
+	virtual void flush() {
+	}
+
+protected:
+	void setWriteError(int err = 1) {
+		write_error = err;
+	}
+
+private:
+	int write_error;
+	size_t printNumber(unsigned long long, uint8_t);
+	size_t printFloat(double, uint8_t);
+	size_t vprintf(const char *format, va_list arg);
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef HOST_STREAMSTRING_H
+#define HOST_STREAMSTRING_H
+
+#include "Arduino.h"
+
+class StreamString: public Stream, public String {
+public:
+	size_t write(const uint8_t *buffer, size_t size) override {
+		return (concat((const char*) buffer, size) ? size : 0);
+	}
+	size_t write(uint8_t data) override {
+		return concat((char) data);
+	}
+	using Print::write;
+
+	int available() override {
+		return length();
+	}
+	int read() override {
+		if (length()) {
+			char c = charAt(0);
+			remove(0, 1);
+			return c;
+		}
+		return -1;
+	}
+	int peek() override {
+		if (length()) {
+			return charAt(0);
+		}
+		return -1;
+	}
+	void flush() override {
+	}
+};
+
+#endif
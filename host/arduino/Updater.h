@@ -0,0 +1,70 @@
+#ifndef HOST_UPDATER_H
+#define HOST_UPDATER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UPDATE_ERROR_OK                 (0)
+#define UPDATE_ERROR_WRITE              (1)
+#define UPDATE_ERROR_ERASE              (2)
+#define UPDATE_ERROR_READ               (3)
+#define UPDATE_ERROR_SPACE              (4)
+#define UPDATE_ERROR_SIZE               (5)
+#define UPDATE_ERROR_STREAM             (6)
+#define UPDATE_ERROR_MD5                (7)
+#define UPDATE_ERROR_FLASH_CONFIG       (8)
+#define UPDATE_ERROR_NEW_FLASH_CONFIG   (9)
+#define UPDATE_ERROR_MAGIC_BYTE         (10)
+#define UPDATE_ERROR_BOOTSTRAP          (11)
+#define UPDATE_ERROR_SIGN               (12)
+
+#define U_FLASH   0
+#define U_FS      100
+
+/*
+ * Host stand-in for the OTA updater: the image is accepted and counted but
+ * never flashed.
+ */
+class UpdaterClass {
+public:
+	void runAsync(bool async) {
+	}
+	bool begin(size_t size, int command = U_FLASH) {
+		this->size = size;
+		this->progress = 0;
+		this->error = UPDATE_ERROR_OK;
+		this->running = true;
+		return true;
+	}
+	size_t write(uint8_t *data, size_t len) {
+		if (!running) {
+			return 0;
+		}
+		if (progress + len > size) {
+			error = UPDATE_ERROR_SPACE;
+			return 0;
+		}
+		progress += len;
+		return len;
+	}
+	bool end(bool evenIfRemaining = false) {
+		running = false;
+		return (error == UPDATE_ERROR_OK);
+	}
+	bool hasError() {
+		return (error != UPDATE_ERROR_OK);
+	}
+	uint8_t getError() {
+		return error;
+	}
+
+private:
+	size_t size = 0;
+	size_t progress = 0;
+	uint8_t error = UPDATE_ERROR_OK;
+	bool running = false;
+};
+
+extern UpdaterClass Update;
+
+#endif
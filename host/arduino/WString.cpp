@@ -0,0 +1,594 @@
+#include "Arduino.h"
+#include <ctype.h>
+#include <utility>
+
+const String emptyString;
+
+String::String(const char *cstr) {
+	init();
+	if (cstr) {
+		copy(cstr, strlen(cstr));
+	}
+}
+
+String::String(const char *cstr, unsigned int length) {
+	init();
+	if (cstr) {
+		copy(cstr, length);
+	}
+}
+
+String::String(const String &value) {
+	init();
+	*this = value;
+}
+
+String::String(String &&rval) noexcept {
+	init();
+	move(rval);
+}
+
+String::String(const __FlashStringHelper *pstr) {
+	init();
+	*this = pstr;
+}
+
+String::String(char c) {
+	init();
+	char buf[2] = { c, '\0' };
+	*this = buf;
+}
+
+String::String(unsigned char value, unsigned char base) {
+	init();
+	char buf[1 + 8 * sizeof(unsigned char)];
+	utoa(value, buf, base);
+	*this = buf;
+}
+
+String::String(int value, unsigned char base) {
+	init();
+	char buf[2 + 8 * sizeof(int)];
+	itoa(value, buf, base);
+	*this = buf;
+}
+
+String::String(unsigned int value, unsigned char base) {
+	init();
+	char buf[1 + 8 * sizeof(unsigned int)];
+	utoa(value, buf, base);
+	*this = buf;
+}
+
+String::String(long value, unsigned char base) {
+	init();
+	char buf[2 + 8 * sizeof(long)];
+	ltoa(value, buf, base);
+	*this = buf;
+}
+
+String::String(unsigned long value, unsigned char base) {
+	init();
+	char buf[1 + 8 * sizeof(unsigned long)];
+	ultoa(value, buf, base);
+	*this = buf;
+}
+
+String::String(long long value, unsigned char base) {
+	init();
+	char buf[2 + 8 * sizeof(long long)];
+	if (base == 10) {
+		snprintf(buf, sizeof(buf), "%lld", value);
+	} else {
+		ultoa((unsigned long) value, buf, base);
+	}
+	*this = buf;
+}
+
+String::String(unsigned long long value, unsigned char base) {
+	init();
+	char buf[1 + 8 * sizeof(unsigned long long)];
+	ultoa((unsigned long) value, buf, base);
+	*this = buf;
+}
+
+String::String(float value, unsigned char decimalPlaces) {
+	init();
+	char buf[33];
+	*this = dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf);
+}
+
+String::String(double value, unsigned char decimalPlaces) {
+	init();
+	char buf[33];
+	*this = dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf);
+}
+
+String::~String() {
+	if (!isSSO()) {
+		free(buffer);
+	}
+}
+
+void String::init() {
+	buffer = sso;
+	capacity = SSO_SIZE - 1;
+	len = 0;
+	sso[0] = '\0';
+}
+
+void String::invalidate() {
+	len = 0;
+	if (buffer) {
+		buffer[0] = '\0';
+	}
+}
+
+unsigned char String::reserve(unsigned int size) {
+	if (capacity >= size) {
+		return 1;
+	}
+	if (changeBuffer(size)) {
+		if (len == 0) {
+			buffer[0] = '\0';
+		}
+		return 1;
+	}
+	return 0;
+}
+
+unsigned char String::changeBuffer(unsigned int maxStrLen) {
+	if (maxStrLen < SSO_SIZE) {
+		if (!isSSO()) {
+			memcpy(sso, buffer, min(len, maxStrLen) + 1);
+			free(buffer);
+			buffer = sso;
+			capacity = SSO_SIZE - 1;
+		}
+		return 1;
+	}
+	// round up like the ESP8266 core so allocation counts match the chip
+	size_t newSize = (maxStrLen + 16) & (~0xf);
+	char *newbuffer = (char *) (isSSO() ? malloc(newSize) : realloc(buffer, newSize));
+	if (newbuffer) {
+		if (isSSO()) {
+			memcpy(newbuffer, sso, len + 1);
+		}
+		buffer = newbuffer;
+		capacity = newSize - 1;
+		return 1;
+	}
+	return 0;
+}
+
+String & String::copy(const char *cstr, unsigned int length) {
+	if (!reserve(length)) {
+		invalidate();
+		return *this;
+	}
+	len = length;
+	memmove(buffer, cstr, length);
+	buffer[len] = '\0';
+	return *this;
+}
+
+void String::move(String &rhs) {
+	if (rhs.isSSO()) {
+		copy(rhs.buffer, rhs.len);
+	} else {
+		if (!isSSO()) {
+			free(buffer);
+		}
+		buffer = rhs.buffer;
+		capacity = rhs.capacity;
+		len = rhs.len;
+		rhs.init();
+	}
+	rhs.invalidate();
+}
+
+String & String::operator =(const String &rhs) {
+	if (this == &rhs) {
+		return *this;
+	}
+	return copy(rhs.buffer, rhs.len);
+}
+
+String & String::operator =(String &&rval) noexcept {
+	if (this != &rval) {
+		move(rval);
+	}
+	return *this;
+}
+
+String & String::operator =(const char *cstr) {
+	if (cstr) {
+		copy(cstr, strlen(cstr));
+	} else {
+		invalidate();
+	}
+	return *this;
+}
+
+String & String::operator =(const __FlashStringHelper *pstr) {
+	return (*this = reinterpret_cast<const char*>(pstr));
+}
+
+String & String::operator =(char c) {
+	char buf[2] = { c, '\0' };
+	return (*this = buf);
+}
+
+unsigned char String::concat(const String &s) {
+	if (&s == this) {
+		unsigned int newlen = 2 * len;
+		if (!reserve(newlen)) {
+			return 0;
+		}
+		memmove(buffer + len, buffer, len);
+		len = newlen;
+		buffer[len] = '\0';
+		return 1;
+	}
+	return concat(s.buffer, s.len);
+}
+
+unsigned char String::concat(const char *cstr, unsigned int length) {
+	unsigned int newlen = len + length;
+	if (!cstr) {
+		return 0;
+	}
+	if (length == 0) {
+		return 1;
+	}
+	if (!reserve(newlen)) {
+		return 0;
+	}
+	memmove(buffer + len, cstr, length);
+	len = newlen;
+	buffer[len] = '\0';
+	return 1;
+}
+
+unsigned char String::concat(const char *cstr) {
+	if (!cstr) {
+		return 0;
+	}
+	return concat(cstr, strlen(cstr));
+}
+
+unsigned char String::concat(const __FlashStringHelper *str) {
+	return concat(reinterpret_cast<const char*>(str));
+}
+
+unsigned char String::concat(char c) {
+	char buf[2] = { c, '\0' };
+	return concat(buf, 1);
+}
+
+unsigned char String::concat(unsigned char num) {
+	char buf[1 + 3 * sizeof(unsigned char)];
+	return concat(utoa(num, buf, 10));
+}
+
+unsigned char String::concat(int num) {
+	char buf[2 + 3 * sizeof(int)];
+	return concat(itoa(num, buf, 10));
+}
+
+unsigned char String::concat(unsigned int num) {
+	char buf[1 + 3 * sizeof(unsigned int)];
+	return concat(utoa(num, buf, 10));
+}
+
+unsigned char String::concat(long num) {
+	char buf[2 + 3 * sizeof(long)];
+	return concat(ltoa(num, buf, 10));
+}
+
+unsigned char String::concat(unsigned long num) {
+	char buf[1 + 3 * sizeof(unsigned long)];
+	return concat(ultoa(num, buf, 10));
+}
+
+unsigned char String::concat(long long num) {
+	char buf[2 + 3 * sizeof(long long)];
+	snprintf(buf, sizeof(buf), "%lld", num);
+	return concat(buf);
+}
+
+unsigned char String::concat(unsigned long long num) {
+	char buf[1 + 3 * sizeof(unsigned long long)];
+	snprintf(buf, sizeof(buf), "%llu", num);
+	return concat(buf);
+}
+
+unsigned char String::concat(float num) {
+	char buf[20];
+	return concat(dtostrf(num, 4, 2, buf));
+}
+
+unsigned char String::concat(double num) {
+	char buf[20];
+	return concat(dtostrf(num, 4, 2, buf));
+}
+
+String operator +(const String &lhs, const String &rhs) {
+	String result;
+	result.reserve(lhs.length() + rhs.length());
+	result.concat(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+String operator +(const char *lhs, const String &rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+int String::compareTo(const String &s) const {
+	if (!buffer || !s.buffer) {
+		if (s.buffer && s.len > 0) {
+			return 0 - *(unsigned char *) s.buffer;
+		}
+		if (buffer && len > 0) {
+			return *(unsigned char *) buffer;
+		}
+		return 0;
+	}
+	return strcmp(buffer, s.buffer);
+}
+
+unsigned char String::equals(const String &s2) const {
+	return (len == s2.len && compareTo(s2) == 0);
+}
+
+unsigned char String::equals(const char *cstr) const {
+	if (len == 0) {
+		return (cstr == nullptr || *cstr == 0);
+	}
+	if (cstr == nullptr) {
+		return buffer[0] == 0;
+	}
+	return strcmp(buffer, cstr) == 0;
+}
+
+unsigned char String::equalsIgnoreCase(const String &s2) const {
+	if (this == &s2) {
+		return 1;
+	}
+	if (len != s2.len) {
+		return 0;
+	}
+	if (len == 0) {
+		return 1;
+	}
+	const char *p1 = buffer;
+	const char *p2 = s2.buffer;
+	while (*p1) {
+		if (tolower(*p1++) != tolower(*p2++)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+unsigned char String::startsWith(const String &s2) const {
+	if (len < s2.len) {
+		return 0;
+	}
+	return startsWith(s2, 0);
+}
+
+unsigned char String::startsWith(const String &s2, unsigned int offset) const {
+	if (offset > (unsigned) (len - s2.len) || !buffer || !s2.buffer) {
+		return 0;
+	}
+	return strncmp(&buffer[offset], s2.buffer, s2.len) == 0;
+}
+
+unsigned char String::endsWith(const String &s2) const {
+	if (len < s2.len || !buffer || !s2.buffer) {
+		return 0;
+	}
+	return strcmp(&buffer[len - s2.len], s2.buffer) == 0;
+}
+
+char String::charAt(unsigned int loc) const {
+	return operator[](loc);
+}
+
+void String::setCharAt(unsigned int loc, char c) {
+	if (loc < len) {
+		buffer[loc] = c;
+	}
+}
+
+char& String::operator[](unsigned int index) {
+	static char dummy_writable_char;
+	if (index >= len || !buffer) {
+		dummy_writable_char = 0;
+		return dummy_writable_char;
+	}
+	return buffer[index];
+}
+
+char String::operator[](unsigned int index) const {
+	if (index >= len || !buffer) {
+		return 0;
+	}
+	return buffer[index];
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+	if (!bufsize || !buf) {
+		return;
+	}
+	if (index >= len) {
+		buf[0] = 0;
+		return;
+	}
+	unsigned int n = bufsize - 1;
+	if (n > len - index) {
+		n = len - index;
+	}
+	strncpy(buf, buffer + index, n);
+	buf[n] = 0;
+}
+
+int String::indexOf(char c) const {
+	return indexOf(c, 0);
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+	if (fromIndex >= len) {
+		return -1;
+	}
+	const char* temp = strchr(buffer + fromIndex, ch);
+	if (temp == nullptr) {
+		return -1;
+	}
+	return temp - buffer;
+}
+
+int String::indexOf(const String &s2) const {
+	return indexOf(s2, 0);
+}
+
+int String::indexOf(const String &s2, unsigned int fromIndex) const {
+	if (fromIndex >= len) {
+		return -1;
+	}
+	const char *found = strstr(buffer + fromIndex, s2.buffer);
+	if (found == nullptr) {
+		return -1;
+	}
+	return found - buffer;
+}
+
+int String::lastIndexOf(char ch) const {
+	const char* temp = strrchr(buffer, ch);
+	if (temp == nullptr) {
+		return -1;
+	}
+	return temp - buffer;
+}
+
+int String::lastIndexOf(const String &s2) const {
+	if (s2.len == 0 || s2.len > len) {
+		return -1;
+	}
+	int found = -1;
+	for (const char *p = buffer; p <= buffer + len - s2.len; p++) {
+		p = strstr(p, s2.buffer);
+		if (!p) {
+			break;
+		}
+		found = p - buffer;
+	}
+	return found;
+}
+
+String String::substring(unsigned int left, unsigned int right) const {
+	if (left > right) {
+		unsigned int temp = right;
+		right = left;
+		left = temp;
+	}
+	String out;
+	if (left > len) {
+		return out;
+	}
+	if (right > len) {
+		right = len;
+	}
+	out.copy(buffer + left, right - left);
+	return out;
+}
+
+void String::replace(char find, char replace) {
+	for (char *p = buffer; *p; p++) {
+		if (*p == find) {
+			*p = replace;
+		}
+	}
+}
+
+void String::replace(const String &find, const String &replace) {
+	if (len == 0 || find.len == 0) {
+		return;
+	}
+	String result;
+	unsigned int pos = 0;
+	while (pos < len) {
+		const char *found = strstr(buffer + pos, find.buffer);
+		if (found == nullptr) {
+			result.concat(buffer + pos, len - pos);
+			break;
+		}
+		unsigned int at = found - buffer;
+		result.concat(buffer + pos, at - pos);
+		result.concat(replace);
+		pos = at + find.len;
+	}
+	move(result);
+}
+
+void String::remove(unsigned int index) {
+	remove(index, (unsigned int) -1);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+	if (index >= len) {
+		return;
+	}
+	if (count > len - index) {
+		count = len - index;
+	}
+	memmove(buffer + index, buffer + index + count, len - index - count + 1);
+	len -= count;
+}
+
+void String::toLowerCase() {
+	for (char *p = buffer; *p; p++) {
+		*p = tolower(*p);
+	}
+}
+
+void String::toUpperCase() {
+	for (char *p = buffer; *p; p++) {
+		*p = toupper(*p);
+	}
+}
+
+void String::trim() {
+	if (!buffer || len == 0) {
+		return;
+	}
+	char *begin = buffer;
+	while (isspace(*begin)) {
+		begin++;
+	}
+	char *end = buffer + len - 1;
+	while (isspace(*end) && end >= begin) {
+		end--;
+	}
+	len = end + 1 - begin;
+	if (begin > buffer) {
+		memmove(buffer, begin, len);
+	}
+	buffer[len] = 0;
+}
+
+long String::toInt() const {
+	return atol(buffer);
+}
+
+float String::toFloat() const {
+	return atof(buffer);
+}
+
+double String::toDouble() const {
+	return atof(buffer);
+}
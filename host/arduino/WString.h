@@ -0,0 +1,155 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+/*
+ * Host stand-in for the Arduino String class. Storage is a heap buffer that
+ * grows on demand exactly like the ESP8266 core, so allocation counts taken
+ * on the host are representative.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "pgmspace.h"
+
+class String {
+public:
+	String(const char *cstr = "");
+	String(const char *cstr, unsigned int length);
+	String(const String &str);
+	String(String &&rval) noexcept;
+	String(const __FlashStringHelper *str);
+	explicit String(char c);
+	explicit String(unsigned char value, unsigned char base = 10);
+	explicit String(int value, unsigned char base = 10);
+	explicit String(unsigned int value, unsigned char base = 10);
+	explicit String(long value, unsigned char base = 10);
+	explicit String(unsigned long value, unsigned char base = 10);
+	explicit String(long long value, unsigned char base = 10);
+	explicit String(unsigned long long value, unsigned char base = 10);
+	explicit String(float value, unsigned char decimalPlaces = 2);
+	explicit String(double value, unsigned char decimalPlaces = 2);
+	~String();
+
+	unsigned char reserve(unsigned int size);
+	unsigned int length() const {
+		return len;
+	}
+
+	String & operator =(const String &rhs);
+	String & operator =(const char *cstr);
+	String & operator =(const __FlashStringHelper *str);
+	String & operator =(String &&rval) noexcept;
+	String & operator =(char c);
+
+	unsigned char concat(const String &str);
+	unsigned char concat(const char *cstr);
+	unsigned char concat(const char *cstr, unsigned int length);
+	unsigned char concat(const __FlashStringHelper *str);
+	unsigned char concat(char c);
+	unsigned char concat(unsigned char c);
+	unsigned char concat(int num);
+	unsigned char concat(unsigned int num);
+	unsigned char concat(long num);
+	unsigned char concat(unsigned long num);
+	unsigned char concat(long long num);
+	unsigned char concat(unsigned long long num);
+	unsigned char concat(float num);
+	unsigned char concat(double num);
+
+	template<typename T> String & operator +=(const T &rhs) {
+		concat(rhs);
+		return (*this);
+	}
+
+	int compareTo(const String &s) const;
+	unsigned char equals(const String &s) const;
+	unsigned char equals(const char *cstr) const;
+	unsigned char operator ==(const String &rhs) const {
+		return equals(rhs);
+	}
+	unsigned char operator ==(const char *cstr) const {
+		return equals(cstr);
+	}
+	unsigned char operator !=(const String &rhs) const {
+		return !equals(rhs);
+	}
+	unsigned char operator !=(const char *cstr) const {
+		return !equals(cstr);
+	}
+	unsigned char operator <(const String &rhs) const {
+		return compareTo(rhs) < 0;
+	}
+	unsigned char equalsIgnoreCase(const String &s) const;
+	unsigned char startsWith(const String &prefix) const;
+	unsigned char startsWith(const String &prefix, unsigned int offset) const;
+	unsigned char endsWith(const String &suffix) const;
+
+	char charAt(unsigned int index) const;
+	void setCharAt(unsigned int index, char c);
+	char operator [](unsigned int index) const;
+	char& operator [](unsigned int index);
+	void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const;
+	const char* c_str() const {
+		return buffer;
+	}
+	char* begin() {
+		return buffer;
+	}
+	char* end() {
+		return buffer + len;
+	}
+
+	int indexOf(char ch) const;
+	int indexOf(char ch, unsigned int fromIndex) const;
+	int indexOf(const String &str) const;
+	int indexOf(const String &str, unsigned int fromIndex) const;
+	int lastIndexOf(char ch) const;
+	int lastIndexOf(const String &str) const;
+	String substring(unsigned int beginIndex) const {
+		return substring(beginIndex, len);
+	}
+	String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+	void replace(char find, char replace);
+	void replace(const String &find, const String &replace);
+	void remove(unsigned int index);
+	void remove(unsigned int index, unsigned int count);
+	void toLowerCase();
+	void toUpperCase();
+	void trim();
+
+	long toInt() const;
+	float toFloat() const;
+	double toDouble() const;
+
+protected:
+	// strings of up to SSO_SIZE - 1 characters live inline, as on the ESP8266 core
+	enum { SSO_SIZE = 11 };
+	char *buffer;
+	unsigned int capacity;
+	unsigned int len;
+	char sso[SSO_SIZE];
+
+	bool isSSO() const {
+		return buffer == sso;
+	}
+
+	void init();
+	void invalidate();
+	unsigned char changeBuffer(unsigned int maxStrLen);
+	String & copy(const char *cstr, unsigned int length);
+	void move(String &rhs);
+};
+
+extern const String emptyString;
+
+String operator +(const String &lhs, const String &rhs);
+String operator +(const char *lhs, const String &rhs);
+template<typename T> String operator +(const String &lhs, const T &rhs) {
+	String result(lhs);
+	result.concat(rhs);
+	return result;
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "WiFiClient.h"
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+WiFiClient::WiFiClient() {
+	this->fd = -1;
+	this->peerClosed = false;
+}
+
+WiFiClient::~WiFiClient() {
+	stop();
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+	return connect(ip.toString().c_str(), port);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+	stop();
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	char service[8];
+	snprintf(service, sizeof(service), "%u", port);
+	struct addrinfo *result = nullptr;
+	if (getaddrinfo(host, service, &hints, &result) != 0) {
+		return 0;
+	}
+	for (struct addrinfo *rp = result; rp != nullptr; rp = rp->ai_next) {
+		int s = socket(rp->ai_family, rp->ai_socktype | SOCK_CLOEXEC, rp->ai_protocol);
+		if (s < 0) {
+			continue;
+		}
+		if (::connect(s, rp->ai_addr, rp->ai_addrlen) == 0) {
+			int one = 1;
+			setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+			fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+			this->fd = s;
+			break;
+		}
+		::close(s);
+	}
+	freeaddrinfo(result);
+	this->peerClosed = false;
+	return (this->fd >= 0 ? 1 : 0);
+}
+
+size_t WiFiClient::write(uint8_t b) {
+	return write(&b, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size) {
+	if (fd < 0) {
+		return 0;
+	}
+	size_t sent = 0;
+	while (sent < size) {
+		ssize_t n = ::send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+		if (n > 0) {
+			sent += n;
+		} else if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+			struct pollfd pfd = { fd, POLLOUT, 0 };
+			if (poll(&pfd, 1, 5000) <= 0) {
+				break;
+			}
+		} else {
+			peerClosed = true;
+			break;
+		}
+	}
+	return sent;
+}
+
+int WiFiClient::available() {
+	if (fd < 0) {
+		return 0;
+	}
+	int n = 0;
+	if (ioctl(fd, FIONREAD, &n) < 0) {
+		return 0;
+	}
+	if (n == 0) {
+		char c;
+		if (::recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+			peerClosed = true;
+		}
+	}
+	return n;
+}
+
+int WiFiClient::read() {
+	uint8_t b;
+	return (read(&b, 1) == 1 ? b : -1);
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size) {
+	if (fd < 0) {
+		return -1;
+	}
+	ssize_t n = ::recv(fd, buf, size, MSG_DONTWAIT);
+	if (n == 0) {
+		peerClosed = true;
+		return -1;
+	}
+	return (n < 0 ? -1 : (int) n);
+}
+
+int WiFiClient::peek() {
+	if (fd < 0) {
+		return -1;
+	}
+	uint8_t b;
+	return (::recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? b : -1);
+}
+
+void WiFiClient::flush() {
+}
+
+void WiFiClient::stop() {
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+	peerClosed = false;
+}
+
+uint8_t WiFiClient::connected() {
+	if (fd < 0) {
+		return 0;
+	}
+	if (available() > 0) {
+		return 1;
+	}
+	return (peerClosed ? 0 : 1);
+}
@@ -0,0 +1,47 @@
+#ifndef HOST_WIFICLIENT_H
+#define HOST_WIFICLIENT_H
+
+#include "Arduino.h"
+#include "Client.h"
+
+/*
+ * Host stand-in for the lwIP TCP client: a plain BSD socket. Reads never
+ * block; available() reports what the kernel has buffered, like the
+ * receive pbuf chain on the chip.
+ */
+class WiFiClient: public Client {
+public:
+	WiFiClient();
+	virtual ~WiFiClient();
+
+	int connect(IPAddress ip, uint16_t port) override;
+	int connect(const char *host, uint16_t port) override;
+	int connect(const String& host, uint16_t port) {
+		return connect(host.c_str(), port);
+	}
+	size_t write(uint8_t) override;
+	size_t write(const uint8_t *buf, size_t size) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int read(uint8_t *buf, size_t size) override;
+	int peek() override;
+	void flush() override;
+	void stop() override;
+	uint8_t connected() override;
+	operator bool() override {
+		return connected();
+	}
+
+	void setNoDelay(bool nodelay) {
+	}
+
+private:
+	int fd;
+	bool peerClosed;
+
+	WiFiClient(const WiFiClient&) = delete;
+	WiFiClient& operator=(const WiFiClient&) = delete;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <vector>
+#include <string>
+
+HardwareSerial Serial;
+EspClass ESP;
+UpdaterClass Update;
+
+static std::vector<std::string> hostArgs;
+static const std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+
+void hostInit(int argc, char** argv) {
+	hostArgs.clear();
+	for (int i = 0; i < argc; i++) {
+		hostArgs.push_back(argv[i]);
+	}
+	// the serial console shows lines as they are written, also when piped
+	setvbuf(stdout, nullptr, _IOLBF, 0);
+}
+
+unsigned long millis() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+unsigned long micros() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+void delay(unsigned long ms) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+	std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+}
+
+static uint8_t hostPins[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+	if ((mode == INPUT_PULLUP) && (pin < sizeof(hostPins))) {
+		hostPins[pin] = HIGH;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+	if (pin < sizeof(hostPins)) {
+		hostPins[pin] = val;
+	}
+}
+
+int digitalRead(uint8_t pin) {
+	return (pin < sizeof(hostPins) ? hostPins[pin] : LOW);
+}
+
+static char* reverse(char* begin, char* end) {
+	char *is = begin;
+	char *ie = end - 1;
+	while (is < ie) {
+		char tmp = *ie;
+		*ie = *is;
+		*is = tmp;
+		++is;
+		--ie;
+	}
+	return begin;
+}
+
+char* ultoa(unsigned long value, char* result, int base) {
+	if (base < 2 || base > 16) {
+		*result = 0;
+		return result;
+	}
+	char* out = result;
+	unsigned long quotient = value;
+	do {
+		const unsigned long tmp = quotient / base;
+		*out = "0123456789abcdef"[quotient - (tmp * base)];
+		++out;
+		quotient = tmp;
+	} while (quotient);
+	reverse(result, out);
+	*out = 0;
+	return result;
+}
+
+char* ltoa(long value, char* result, int base) {
+	if (base < 2 || base > 16) {
+		*result = 0;
+		return result;
+	}
+	char* out = result;
+	unsigned long quotient = (value < 0 && base == 10) ? -(unsigned long) value : (unsigned long) value;
+	do {
+		const unsigned long tmp = quotient / base;
+		*out = "0123456789abcdef"[quotient - (tmp * base)];
+		++out;
+		quotient = tmp;
+	} while (quotient);
+	if (value < 0 && base == 10) {
+		*out++ = '-';
+	}
+	reverse(result, out);
+	*out = 0;
+	return result;
+}
+
+char* utoa(unsigned int value, char* result, int base) {
+	return ultoa(value, result, base);
+}
+
+char* itoa(int value, char* result, int base) {
+	if (base == 10) {
+		return ltoa(value, result, base);
+	}
+	return ultoa((unsigned int) value, result, base);
+}
+
+char* dtostrf(double number, signed char width, unsigned char prec, char* s) {
+	sprintf(s, "%*.*f", width, prec, number);
+	return s;
+}
+
+void EspClass::restart() {
+	fflush(stdout);
+	if (!hostArgs.empty()) {
+		std::vector<char*> argv;
+		for (std::string &arg : hostArgs) {
+			argv.push_back(&arg[0]);
+		}
+		argv.push_back(nullptr);
+		execv("/proc/self/exe", argv.data());
+	}
+	exit(0);
+}
+
+int HardwareSerial::available() {
+	if (peeked >= 0) {
+		return 1;
+	}
+	int n = 0;
+	if (ioctl(STDIN_FILENO, FIONREAD, &n) < 0) {
+		return 0;
+	}
+	return n;
+}
+
+int HardwareSerial::read() {
+	if (peeked >= 0) {
+		int c = peeked;
+		peeked = -1;
+		return c;
+	}
+	if (available() <= 0) {
+		return -1;
+	}
+	unsigned char c;
+	return (::read(STDIN_FILENO, &c, 1) == 1 ? c : -1);
+}
+
+int HardwareSerial::peek() {
+	if (peeked < 0) {
+		peeked = read();
+	}
+	return peeked;
+}
+
+void HardwareSerial::flush() {
+	fflush(stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	return (fputc(c, stdout) == EOF ? 0 : 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+	return fwrite(buffer, 1, size, stdout);
+}
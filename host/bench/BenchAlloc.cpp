@@ -0,0 +1,37 @@
+#include "BenchAlloc.h"
+
+size_t benchAllocCount = 0;
+size_t benchAllocBytes = 0;
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+	benchAllocCount++;
+	benchAllocBytes += size;
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+	benchAllocCount++;
+	benchAllocBytes += count * size;
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+	if (size > 0) {
+		benchAllocCount++;
+		benchAllocBytes += size;
+	}
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+	__libc_free(ptr);
+}
+
+}
@@ -0,0 +1,10 @@
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <stddef.h>
+
+/* Counts heap allocations (malloc, calloc, realloc and so operator new) of the benchmark process. */
+extern size_t benchAllocCount;
+extern size_t benchAllocBytes;
+
+#endif
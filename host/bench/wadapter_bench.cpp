@@ -0,0 +1,435 @@
+/*
+ * Microbenchmarks for the code that runs on every publish and every HTTP
+ * request: WJson serialization, WJsonParser, WStringStream, WProperty and
+ * the /things handlers end to end.
+ *
+ *   wadapter_bench [filter] [--min-time ms]
+ *
+ * For each case it prints the time per operation, the bytes the operation
+ * produced and the heap allocations (count and bytes) per operation. The
+ * memory/ cases print the RAM a property takes (object size of this build,
+ * 64 bit on the host, plus what its setup allocates).
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <unistd.h>
+#include "WNetwork.h"
+#include "WNetworkDevice.h"
+#include "../WHostThermostat.h"
+#include "BenchAlloc.h"
+
+typedef std::function<size_t(void)> BenchOp;
+
+static const char* benchFilter = nullptr;
+static double benchMinTimeNs = 200e6;
+
+/* Print that only counts, so output cost doesn't distort the results */
+class BenchSink: public Print {
+public:
+	size_t written = 0;
+	size_t write(uint8_t c) override {
+		written++;
+		return 1;
+	}
+	size_t write(const uint8_t *buffer, size_t size) override {
+		written += size;
+		return size;
+	}
+};
+
+static double runOp(const BenchOp& op, unsigned long iterations, size_t* produced) {
+	auto start = std::chrono::steady_clock::now();
+	size_t bytes = 0;
+	for (unsigned long i = 0; i < iterations; i++) {
+		bytes += op();
+	}
+	auto end = std::chrono::steady_clock::now();
+	if (produced != nullptr) {
+		*produced = bytes;
+	}
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static void bench(const char* name, const BenchOp& op) {
+	if ((benchFilter != nullptr) && (strstr(name, benchFilter) == nullptr)) {
+		return;
+	}
+	// warm up, then grow the iteration count until a run takes long enough
+	op();
+	unsigned long iterations = 1;
+	double elapsed = runOp(op, iterations, nullptr);
+	while (elapsed < benchMinTimeNs / 10) {
+		double factor = (elapsed > 0 ? (benchMinTimeNs / elapsed) : 100);
+		iterations = (unsigned long) (iterations * std::min(100.0, std::max(2.0, factor)));
+		elapsed = runOp(op, iterations, nullptr);
+	}
+	iterations = std::max(1UL, (unsigned long) (iterations * benchMinTimeNs / elapsed));
+	size_t allocCount = benchAllocCount;
+	size_t allocBytes = benchAllocBytes;
+	size_t produced;
+	elapsed = runOp(op, iterations, &produced);
+	printf("%-34s %12.1f %10.1f %10.2f %12.1f\n", name,
+			elapsed / iterations,
+			(double) produced / iterations,
+			(double) (benchAllocCount - allocCount) / iterations,
+			(double) (benchAllocBytes - allocBytes) / iterations);
+}
+
+static const char* STATE_PAYLOAD = "{\"on\":true,\"targetTemperature\":23.5,\"mode\":\"cool\",\"fan\":3}";
+static const char* NESTED_PAYLOAD = "{\"thermostat\":{\"on\":true,\"schedule\":{\"from\":\"06:00\",\"to\":\"22:00\"},\"targetTemperature\":23.5}}";
+static const char* PUT_PAYLOAD = "{\"targetTemperature\":24.5}";
+
+static void benchStringStream() {
+	const char* text = "{\"idx\":\"wadapterhost\",\"ip\":\"127.0.0.1\",\"firmware\":\"1.15-fas\",\"on\":true,"
+			"\"temperature\":21.00,\"targetTemperature\":22.50,\"mode\":\"heat\",\"fan\":2}";
+	size_t textLength = strlen(text);
+	WStringStream* stream = new WStringStream(512);
+	bench("stringstream/write-bytes", [=]() {
+		stream->flush();
+		for (size_t i = 0; i < textLength; i++) {
+			stream->write((uint8_t) text[i]);
+		}
+		return (size_t) stream->length();
+	});
+	bench("stringstream/print", [=]() {
+		stream->flush();
+		stream->print(text);
+		return (size_t) stream->length();
+	});
+	bench("stringstream/printf", [=]() {
+		stream->flush();
+		stream->printf(F("{\"%s\":%d,\"%s\":\"%s\"}"), "fan", 3, "mode", "heat");
+		return (size_t) stream->length();
+	});
+	bench("stringstream/read", [=]() {
+		stream->flush();
+		stream->print(text);
+		size_t read = 0;
+		while (stream->read() >= 0) {
+			read++;
+		}
+		return read;
+	});
+}
+
+static void benchJson(WNetwork* network, WDevice* device) {
+	WStringStream* stream = new WStringStream(SIZE_MQTT_PACKET);
+	bench("json/values", [=]() {
+		// as the MQTT state message
+		stream->flush();
+		WJson json(stream);
+		json.beginObject();
+		json.propertyString(PROP_IDX, network->getIdx());
+		json.propertyString("ip", "127.0.0.1");
+		json.propertyString("firmware", "1.15-fas");
+		device->toJsonValues(&json, MQTT);
+		json.endObject();
+		return (size_t) stream->length();
+	});
+	bench("json/values-cbor", [=]() {
+		// the same in CBOR
+		stream->flush();
+		WCbor cbor(stream);
+		cbor.beginObject();
+		cbor.propertyString(PROP_IDX, network->getIdx());
+		cbor.propertyString("ip", "127.0.0.1");
+		cbor.propertyString("firmware", "1.15-fas");
+		device->toCborValues(&cbor, MQTT);
+		cbor.endObject();
+		return (size_t) stream->length();
+	});
+	WStringStream* structureStream = new WStringStream(3096);
+	bench("json/structure", [=]() {
+		structureStream->flush();
+		WJson json(structureStream);
+		json.beginArray();
+		device->toJsonStructure(&json, "/things", WEBTHING);
+		json.endArray();
+		return (size_t) structureStream->length();
+	});
+	bench("json/structure-count", [=]() {
+		WJson json;
+		json.beginArray();
+		device->toJsonStructure(&json, "/things", WEBTHING);
+		json.endArray();
+		return json.length();
+	});
+	bench("json/structure-pieces", [=]() {
+		// generator without cache, in chunks of a chunked response
+		uint8_t buffer[ASYNC_HOST_SEGMENT_SIZE - 8];
+		WStructureGenerator generator(device, "/things", WEBTHING, true, false);
+		size_t length = 0;
+		size_t filled;
+		while ((filled = generator.fill(buffer, sizeof(buffer))) > 0) {
+			length += filled;
+		}
+		return length;
+	});
+	bench("json/values-sink", [=]() {
+		BenchSink sink;
+		WJson json(&sink);
+		json.beginObject();
+		device->toJsonValues(&json, WEBTHING);
+		json.endObject();
+		return sink.written;
+	});
+	bench("json/values-response", [=]() {
+		AsyncResponseStream* response = new AsyncResponseStream(APPLICATION_JSON, 1460);
+		WJson json(response);
+		json.beginObject();
+		device->toJsonValues(&json, WEBTHING);
+		json.endObject();
+		// the server sends it from here
+		BenchSink sink;
+		size_t length = response->_write(&sink);
+		delete response;
+		return length;
+	});
+}
+
+static void benchParser(WDevice* device) {
+	bench("parser/mqtt-state", [=]() {
+		WJsonParser* parser = new WJsonParser();
+		parser->parse(STATE_PAYLOAD, device);
+		delete parser;
+		return (size_t) 0;
+	});
+	WJsonParser* reused = new WJsonParser();
+	bench("parser/mqtt-state-reused", [=]() {
+		// as WNetwork keeps its parsers
+		reused->parse(STATE_PAYLOAD, strlen(STATE_PAYLOAD), device);
+		return (size_t) 0;
+	});
+	WStringStream* cborState = new WStringStream(SIZE_MQTT_PACKET);
+	WCbor cbor(cborState);
+	cbor.beginObject();
+	cbor.propertyBoolean("on", true);
+	cbor.propertyDouble("targetTemperature", 23.5);
+	cbor.propertyString("mode", "cool");
+	cbor.propertyInteger("fan", 3);
+	cbor.endObject();
+	bench("parser/mqtt-state-cbor", [=]() {
+		WCborParser* parser = new WCborParser();
+		parser->parse((const uint8_t*) cborState->c_str(), cborState->length(), device);
+		delete parser;
+		return (size_t) 0;
+	});
+	bench("parser/put-property", [=]() {
+		WJsonParser parser;
+		parser.parse(PUT_PAYLOAD, device);
+		return (size_t) 0;
+	});
+	bench("parser/events", [=]() {
+		// nested document to a listener, counting the events
+		class CountingListener: public WJsonListener {
+		public:
+			size_t events = 0;
+			void beginObject() override { events++; }
+			void endObject() override { events++; }
+			void key(const char* key, size_t length) override { events++; }
+			void valueString(const char* value, size_t length) override { events++; }
+			void valueNumber(const char* value, size_t length) override { events++; }
+			void valueBoolean(bool value) override { events++; }
+		} listener;
+		reused->begin(&listener);
+		reused->feed(NESTED_PAYLOAD, strlen(NESTED_PAYLOAD));
+		return listener.events;
+	});
+	bench("parser/key-value", [=]() {
+		WJsonParser parser;
+		size_t values = 0;
+		parser.parse(STATE_PAYLOAD, [&values](const char* key, const char* value) {
+			values++;
+		});
+		return (size_t) 0;
+	});
+}
+
+static void benchProperty(WDevice* device) {
+	WProperty* targetTemperature = device->getPropertyById("targetTemperature");
+	WProperty* fan = device->getPropertyById("fan");
+	WProperty* mode = device->getPropertyById("mode");
+	targetTemperature->setOnChange([](WProperty* p) {});
+	double value = 20.0;
+	bench("property/set-double", [=]() mutable {
+		value = (value < 25.0 ? value + 0.5 : 20.0);
+		targetTemperature->setDouble(value);
+		return (size_t) 0;
+	});
+	bench("property/set-double-same", [=]() {
+		targetTemperature->setDouble(22.0);
+		return (size_t) 0;
+	});
+	bench("property/get-double", [=]() {
+		volatile double d = targetTemperature->getDouble();
+		(void) d;
+		return (size_t) 0;
+	});
+	WTypedProperty<double>* typedTemperature = (WTypedProperty<double>*) targetTemperature;
+	bench("property/set-double-typed", [=]() mutable {
+		value = (value < 25.0 ? value + 0.5 : 20.0);
+		typedTemperature->set(value);
+		return (size_t) 0;
+	});
+	bench("property/json-value-typed", [=]() {
+		BenchSink sink;
+		WJson json(&sink);
+		typedTemperature->toJsonValue(&json, true);
+		json.flush();
+		return sink.written;
+	});
+	// outside the sample device, which keeps the default two decimals the other cases compare against
+	WProperty* steppedTemperature = new WProperty("steppedTemperature", "Stepped", DOUBLE);
+	steppedTemperature->setMultipleOf(0.5);
+	steppedTemperature->setDouble(22.5);
+	bench("property/json-value-multipleof", [=]() {
+		BenchSink sink;
+		WJson json(&sink);
+		steppedTemperature->toJsonValue(&json, true);
+		json.flush();
+		return sink.written;
+	});
+	int level = 0;
+	bench("property/set-integer", [=]() mutable {
+		level = (level + 1) % 6;
+		fan->setInteger(level);
+		return (size_t) 0;
+	});
+	bool heat = false;
+	bench("property/set-string-enum", [=]() mutable {
+		heat = !heat;
+		mode->setString(heat ? "heat" : "cool");
+		return (size_t) 0;
+	});
+	bench("property/parse-double", [=]() {
+		targetTemperature->parse("23.5");
+		return (size_t) 0;
+	});
+	bench("property/to-string", [=]() {
+		return (size_t) targetTemperature->toString().length();
+	});
+	bench("property/lookup", [=]() {
+		return (size_t) (device->getPropertyById("fan") != nullptr ? 0 : 1);
+	});
+	// a device with many properties, looked up by its last one
+	static char ids[48][16];
+	WDevice* large = new WDevice(nullptr, "large", "large", "bench", DEVICE_TYPE_THERMOSTAT);
+	for (int i = 0; i < 48; i++) {
+		snprintf(ids[i], sizeof(ids[i]), "sensorValue%d", i);
+		large->addProperty(new WProperty(ids[i], ids[i], DOUBLE));
+	}
+	bench("property/lookup-48", [=]() {
+		return (size_t) (large->getPropertyById("sensorValue47") != nullptr ? 0 : 1);
+	});
+}
+
+static void memory(const char* name, size_t objectSize, const std::function<WProperty*(const char*)>& create) {
+	if ((benchFilter != nullptr) && (strstr(name, benchFilter) == nullptr)) {
+		return;
+	}
+	// as a device sets it up: own onChange, added to a device
+	const int count = 16;
+	static char ids[count][16];
+	WDevice* device = new WDevice(nullptr, "memory", "memory", "bench", DEVICE_TYPE_THERMOSTAT);
+	size_t allocCount = benchAllocCount;
+	size_t allocBytes = benchAllocBytes;
+	for (int i = 0; i < count; i++) {
+		snprintf(ids[i], sizeof(ids[i]), "memory%d", i);
+		WProperty* property = create(ids[i]);
+		property->setOnChange([](WProperty* property) {});
+		device->addProperty(property);
+	}
+	printf("%-34s %12zu %10.1f %10.2f\n", name, objectSize,
+			(double) (benchAllocBytes - allocBytes) / count,
+			(double) (benchAllocCount - allocCount) / count);
+}
+
+static void benchMemory() {
+	printf("\n%-34s %12s %10s %10s\n", "memory", "sizeof", "heap B", "allocs");
+	memory("memory/property-double", sizeof(WProperty), [](const char* id) {
+		return new WProperty(id, id, DOUBLE);
+	});
+	memory("memory/property-string", sizeof(WStringProperty), [](const char* id) {
+		return new WStringProperty(id, id, 8);
+	});
+	memory("memory/property-string-enum", sizeof(WStringProperty), [](const char* id) {
+		WProperty* property = new WStringProperty(id, id, 4);
+		property->addEnumString("off");
+		property->addEnumString("heat");
+		property->addEnumString("cool");
+		return property;
+	});
+	memory("memory/property-enum", sizeof(WEnumProperty), [](const char* id) {
+		return new WEnumProperty(id, id, MODES, 3);
+	});
+	memory("memory/property-temperature", sizeof(WTemperatureProperty), [](const char* id) {
+		return new WTemperatureProperty(id, id);
+	});
+}
+
+static size_t httpRequest(WebRequestMethodComposite method, const char* url, const char* body = nullptr) {
+	BenchSink sink;
+	int code = webServer->handleRequest(method, url, (const uint8_t*) body, (body != nullptr ? strlen(body) : 0),
+			(body != nullptr ? APPLICATION_JSON : nullptr), &sink);
+	if (code != 200) {
+		fprintf(stderr, "%s %s: HTTP %d\n", (method == HTTP_PUT ? "PUT" : "GET"), url, code);
+		exit(1);
+	}
+	return sink.written;
+}
+
+static void benchHttp() {
+	bench("http/get-things", []() {
+		return httpRequest(HTTP_GET, "/things");
+	});
+	bench("http/get-device", []() {
+		return httpRequest(HTTP_GET, "/things/thermostat");
+	});
+	bench("http/get-properties", []() {
+		return httpRequest(HTTP_GET, "/things/thermostat/properties");
+	});
+	bench("http/get-property", []() {
+		return httpRequest(HTTP_GET, "/things/thermostat/properties/targetTemperature");
+	});
+	bench("http/put-property", []() {
+		return httpRequest(HTTP_PUT, "/things/thermostat/properties/targetTemperature", PUT_PAYLOAD);
+	});
+}
+
+int main(int argc, char** argv) {
+	hostInit(argc, argv);
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "--min-time") == 0) && (i + 1 < argc)) {
+			benchMinTimeNs = atof(argv[++i]) * 1e6;
+		} else {
+			benchFilter = argv[i];
+		}
+	}
+	// settings of the benchmark must not touch the ones of wadapter_host
+	char eepromFile[] = "/tmp/wadapter-bench-XXXXXX";
+	int fd = mkstemp(eepromFile);
+	if (fd >= 0) {
+		close(fd);
+		unlink(eepromFile);
+	}
+	setenv("WADAPTER_EEPROM", eepromFile, 1);
+	httpPort = 0;
+
+	WNetwork* network = new WNetwork(false, "WAdapterBench", "1.15-fas", NO_LED, 0x01);
+	WDevice* device = new WHostThermostat(network);
+	network->addDevice(device);
+	network->addDevice(new WNetworkDev(network, "WAdapterBench"));
+	network->startWebServer();
+	initStatic();
+
+	printf("%-34s %12s %10s %10s %12s\n", "benchmark", "ns/op", "bytes/op", "allocs/op", "alloc B/op");
+	benchStringStream();
+	benchJson(network, device);
+	benchParser(device);
+	benchProperty(device);
+	benchHttp();
+	benchMemory();
+	unlink(eepromFile);
+	return 0;
+}
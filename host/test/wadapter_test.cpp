@@ -0,0 +1,413 @@
+/*
+ * Tests of the host build, run by ctest:
+ *
+ *   wadapter_test [filter]
+ *
+ * Each case prints the checks that failed and ok or FAILED; the exit code
+ * is the number of failed cases.
+ */
+
+#include <Arduino.h>
+#include <climits>
+#include <string>
+#include "WNetwork.h"
+
+typedef std::function<void(void)> TestCase;
+
+static const char* testFilter = nullptr;
+static int testsFailed = 0;
+static bool testFailed = false;
+
+static void check(bool condition, const char* text, const char* file, int line) {
+	if (!condition) {
+		printf("  %s:%d: %s\n", file, line, text);
+		testFailed = true;
+	}
+}
+
+static void checkString(const std::string& expected, const std::string& actual, const char* what, const char* file, int line) {
+	if (expected != actual) {
+		printf("  %s:%d: %s: expected '%s', got '%s'\n", file, line, what, expected.c_str(), actual.c_str());
+		testFailed = true;
+	}
+}
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_STRING(expected, actual, what) checkString((expected), (actual), (what), __FILE__, __LINE__)
+
+static void test(const char* name, const TestCase& body) {
+	if ((testFilter != nullptr) && (strstr(name, testFilter) == nullptr)) {
+		return;
+	}
+	testFailed = false;
+	body();
+	printf("%-34s %s\n", name, (testFailed ? "FAILED" : "ok"));
+	if (testFailed) {
+		testsFailed++;
+	}
+}
+
+/* Print that keeps the output */
+class TestPrint: public Print {
+public:
+	std::string text;
+	size_t write(uint8_t c) override {
+		text.push_back((char) c);
+		return 1;
+	}
+	size_t write(const uint8_t *buffer, size_t size) override {
+		text.append((const char*) buffer, size);
+		return size;
+	}
+};
+
+static std::string toString(WProperty* property) {
+	return (property->isNull() ? std::string("null") : std::string(property->toString().c_str()));
+}
+
+/* Device with a property of each type; values are set only for the source of a round trip */
+static WDevice* newValuesDevice(bool withValues) {
+	WDevice* device = new WDevice(nullptr, "values", "values", "values", DEVICE_TYPE_THERMOSTAT);
+	WProperty* integer = new WProperty("integer", "integer", INTEGER);
+	WProperty* minimum = new WProperty("minimum", "minimum", INTEGER);
+	WProperty* longValue = new WProperty("long", "long", LONG);
+	WProperty* unsignedValue = new WProperty("unsigned", "unsigned", UNSIGNED_LONG);
+	WProperty* byteValue = new WProperty("byte", "byte", BYTE);
+	WProperty* half = new WProperty("half", "half", DOUBLE);
+	WProperty* fraction = new WProperty("fraction", "fraction", DOUBLE);
+	WProperty* negative = new WProperty("negative", "negative", DOUBLE);
+	WProperty* large = new WProperty("large", "large", DOUBLE);
+	WProperty* precise = new WProperty("precise", "precise", DOUBLE);
+	precise->setMultipleOf(0.001);
+	WProperty* on = new WProperty("on", "on", BOOLEAN);
+	WProperty* text = new WProperty("text", "text", STRING);
+	device->addProperty(integer);
+	device->addProperty(minimum);
+	device->addProperty(longValue);
+	device->addProperty(unsignedValue);
+	device->addProperty(byteValue);
+	device->addProperty(half);
+	device->addProperty(fraction);
+	device->addProperty(negative);
+	device->addProperty(large);
+	device->addProperty(precise);
+	device->addProperty(on);
+	device->addProperty(text);
+	if (withValues) {
+		integer->setInteger(-42);
+		minimum->setInteger(INT_MIN);
+		longValue->setLong(-2000000000L);
+		unsignedValue->setUnsignedLong(4000000000UL);
+		byteValue->setByte(200);
+		half->setDouble(-12.75);
+		fraction->setDouble(0.1);
+		negative->setDouble(-273.15);
+		large->setDouble(123456.78);
+		precise->setDouble(-3.14159);
+		on->setBoolean(true);
+		text->setString("K\xC3\xBC" "che");
+	}
+	return device;
+}
+
+/*
+ * Nested map sent ahead of the values, which the parsers pass over. Its keys
+ * are no property ids, the JSON parser doesn't tell nesting levels apart.
+ */
+template<class W> static void writeSchedule(W* writer) {
+	writer->beginObject("schedule");
+	writer->propertyString("from", "06:00");
+	writer->propertyInteger("offset", -5);
+	writer->beginObject("window");
+	writer->propertyDouble("delta", -0.5);
+	writer->endObject();
+	writer->endObject();
+}
+
+static void testCborRoundTrip() {
+	WDevice* source = newValuesDevice(true);
+	TestPrint json;
+	{
+		WJson writer(&json);
+		writer.beginObject();
+		writeSchedule(&writer);
+		source->toJsonValues(&writer, MQTT);
+		writer.endObject();
+	}
+	TestPrint cbor;
+	{
+		WCbor writer(&cbor);
+		writer.beginObject();
+		writeSchedule(&writer);
+		source->toCborValues(&writer, MQTT);
+		writer.endObject();
+	}
+	WDevice* fromJson = newValuesDevice(false);
+	WJsonParser jsonParser;
+	jsonParser.parse(json.text.c_str(), json.text.length(), fromJson);
+	CHECK(jsonParser.isDone());
+	WDevice* fromCbor = newValuesDevice(false);
+	WCborParser cborParser;
+	cborParser.parse((const uint8_t*) cbor.text.data(), cbor.text.length(), fromCbor);
+	// both paths end with the values the source sent
+	WProperty* property = source->firstProperty;
+	while (property != nullptr) {
+		WProperty* jsonProperty = fromJson->getPropertyById(property->getId());
+		WProperty* cborProperty = fromCbor->getPropertyById(property->getId());
+		CHECK_STRING(toString(property), toString(jsonProperty), property->getId());
+		CHECK_STRING(toString(jsonProperty), toString(cborProperty), property->getId());
+		property = property->next;
+	}
+	CHECK(fromCbor->getPropertyById("integer")->getInteger() == -42);
+	CHECK(fromCbor->getPropertyById("minimum")->getInteger() == INT_MIN);
+	CHECK(fromCbor->getPropertyById("long")->getLong() == -2000000000L);
+	CHECK(fromCbor->getPropertyById("half")->getDouble() == -12.75);
+	CHECK(fromCbor->getPropertyById("negative")->getDouble() == fromJson->getPropertyById("negative")->getDouble());
+	CHECK(fromCbor->getPropertyById("precise")->getDouble() == fromJson->getPropertyById("precise")->getDouble());
+	// CBOR is the smaller encoding of the same state
+	CHECK(cbor.text.length() < json.text.length());
+}
+
+static std::string printed(double number, unsigned int digits) {
+	TestPrint out;
+	out.print(number, digits);
+	return out.text;
+}
+
+// number as WJson writes it: formatDouble, or Print::print beyond its range
+static std::string written(double number, unsigned int digits) {
+	TestPrint out;
+	{
+		WJson json(&out);
+		json.numberDouble(number, digits);
+	}
+	return out.text;
+}
+
+static void checkFormatDouble(double number, unsigned int digits, const char* file, int line) {
+	char what[64];
+	snprintf(what, sizeof(what), "%.17g with %u digits", number, digits);
+	char text[WJSON_DOUBLE_LENGTH];
+	unsigned int length = WJson::formatDouble(text, number, digits);
+	if (length > 0) {
+		checkString(printed(number, digits), std::string(text, length), what, file, line);
+	}
+	checkString(printed(number, digits), written(number, digits), what, file, line);
+}
+
+#define CHECK_FORMAT_DOUBLE(number, digits) checkFormatDouble((number), (digits), __FILE__, __LINE__)
+
+static void testFormatDoubleBoundaries() {
+	// halves that are no halves in binary, and exact ones that round to even
+	static const double numbers[] = { 0.005, 0.015, 0.025, 0.045, 1.005, 2.675, 1.115, 0.125, 0.375, 2.5, 0.5, 1.5,
+			-0.005, -2.675, -0.125, 0.0, -0.0, -0.001, -0.004, 0.0049999999999999999, 1e-7, -1e-7,
+			999999.995, 999999999.4, 999999999.5, 1e9, 1e9 + 0.5, -1e9, 4294967295.5, 1e15, -1e20, 1.7976931348623157e308 };
+	for (double number : numbers) {
+		for (unsigned int digits = 0; digits <= 6; digits++) {
+			CHECK_FORMAT_DOUBLE(number, digits);
+		}
+	}
+	// -0.0 keeps its sign, like printf
+	CHECK_STRING("-0.00", written(-0.0, 2), "-0.0");
+	CHECK_STRING(printed(NAN, 2), written(NAN, 2), "nan");
+	CHECK_STRING(printed(-INFINITY, 2), written(-INFINITY, 2), "-inf");
+}
+
+static void testFormatDoubleSweep() {
+	// every step of a thousandth around zero, and pseudo random numbers of all magnitudes up to formatDouble's limit
+	for (int i = -20000; i <= 20000; i++) {
+		for (unsigned int digits = 0; digits <= 4; digits++) {
+			CHECK_FORMAT_DOUBLE(i / 1000.0, digits);
+		}
+	}
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	for (int i = 0; i < 100000; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		double number = ((double) (seed >> 11) / (double) (1ULL << 53)) * pow(10, (int) (seed % 12) - 2);
+		CHECK_FORMAT_DOUBLE(((seed & 1) ? -number : number), (unsigned int) ((seed >> 4) % 7));
+		if (testFailed) {
+			break;
+		}
+	}
+}
+
+static void testDecimalsOfMultipleOf() {
+	struct {
+		double multipleOf;
+		unsigned int decimals;
+	} cases[] = { { 0.0, 2 }, { 5, 0 }, { 1, 0 }, { 0.5, 1 }, { 0.1, 1 }, { 0.25, 2 }, { 0.05, 2 }, { 0.001, 3 }, { 0.0005, 4 }, { 1e-6, 6 }, { 1e-9, 6 } };
+	// kept like the properties of a device; WProperty deletes its id
+	WProperty* property = new WProperty("value", "value", DOUBLE);
+	for (auto& c : cases) {
+		property->setMultipleOf(c.multipleOf);
+		char what[32];
+		snprintf(what, sizeof(what), "multipleOf %g", c.multipleOf);
+		check(property->getDecimals() == c.decimals, what, __FILE__, __LINE__);
+		for (double number : { 21.255, -0.0449, 2.675, 0.5, 123456.7891, -0.0 }) {
+			property->setDouble(number);
+			TestPrint out;
+			{
+				WJson json(&out);
+				property->toJsonValue(&json, true);
+			}
+			checkString(printed(number, c.decimals), out.text, what, __FILE__, __LINE__);
+		}
+	}
+}
+
+/* Writes the events of a document as text, to compare parses */
+class RecordingListener: public WJsonListener {
+public:
+	std::string events;
+	void beginObject() override {
+		events += "{";
+	}
+	void endObject() override {
+		events += "}";
+	}
+	void beginArray() override {
+		events += "[";
+	}
+	void endArray() override {
+		events += "]";
+	}
+	void key(const char* key, size_t length) override {
+		events += "k:" + std::string(key, length) + ";";
+	}
+	void valueString(const char* value, size_t length) override {
+		events += "s:" + std::string(value, length) + ";";
+	}
+	void valueNumber(const char* value, size_t length) override {
+		events += "n:" + std::string(value, length) + ";";
+	}
+	void valueBoolean(bool value) override {
+		events += (value ? "true;" : "false;");
+	}
+	void valueNull() override {
+		events += "null;";
+	}
+	void endDocument() override {
+		events += "end";
+	}
+};
+
+static const char* SPLIT_PAYLOAD = " { \"on\" : true, \"off\":false ,\"none\":null,"
+		"\"integer\":-42,\"double\":-273.15,\"exponent\":6.02e+23,\"small\":1E-7,"
+		"\"text\":\"quote \\\" backslash \\\\ slash \\/ tab \\t K\\u00fcche \\ud83d\\ude00 K\xC3\xBC" "che\","
+		"\"nested\":{\"list\":[1,[2,{\"deep\":[]}],\"x\",{}],\"empty\":\"\"},"
+		"\"a key longer than the 64 bytes of the buffer of the parser, which is cut there\":\"value\","
+		"\"last\":0}";
+
+static std::string parseEvents(const char* payload, size_t length, size_t pieceLength, bool* done) {
+	WJsonParser parser;
+	RecordingListener listener;
+	parser.begin(&listener);
+	for (size_t index = 0; index < length; index += pieceLength) {
+		parser.feed(payload + index, min(pieceLength, length - index));
+	}
+	*done = parser.isDone();
+	return listener.events;
+}
+
+static void testJsonSplitAtEveryOffset() {
+	size_t length = strlen(SPLIT_PAYLOAD);
+	bool done;
+	std::string whole = parseEvents(SPLIT_PAYLOAD, length, length, &done);
+	CHECK(done);
+	CHECK(whole.find("k:text;s:quote \" backslash \\ slash / tab \t K") != std::string::npos);
+	CHECK(whole.find("k:last;n:0;}end") != std::string::npos);
+	for (size_t split = 1; split < length; split++) {
+		WJsonParser parser;
+		RecordingListener listener;
+		parser.begin(&listener);
+		parser.feed(SPLIT_PAYLOAD, split);
+		parser.feed(SPLIT_PAYLOAD + split, length - split);
+		char what[32];
+		snprintf(what, sizeof(what), "split at %zu", split);
+		checkString(whole, listener.events, what, __FILE__, __LINE__);
+		check(parser.isDone(), what, __FILE__, __LINE__);
+	}
+	// in pieces of every length, down to single bytes
+	for (size_t pieceLength = 1; pieceLength < length; pieceLength++) {
+		char what[32];
+		snprintf(what, sizeof(what), "pieces of %zu", pieceLength);
+		checkString(whole, parseEvents(SPLIT_PAYLOAD, length, pieceLength, &done), what, __FILE__, __LINE__);
+		check(done, what, __FILE__, __LINE__);
+	}
+	// values set to a device are the same, however the body arrives
+	WDevice* device = newValuesDevice(false);
+	const char* values = "{\"integer\":-42,\"half\":-12.75,\"precise\":3.1416,\"on\":true,\"text\":\"K\\u00fcche\"}";
+	WJsonParser parser;
+	WProperty* updated = parser.parse(values, strlen(values), device);
+	std::string expected;
+	for (WProperty* property = device->firstProperty; property != nullptr; property = property->next) {
+		expected += toString(property) + ";";
+	}
+	for (size_t split = 1; split < strlen(values); split++) {
+		WDevice* other = newValuesDevice(false);
+		parser.begin(other);
+		parser.feed(values, split);
+		WProperty* last = parser.feed(values + split, strlen(values) - split);
+		std::string actual;
+		for (WProperty* property = other->firstProperty; property != nullptr; property = property->next) {
+			actual += toString(property) + ";";
+		}
+		CHECK_STRING(expected, actual, "device values");
+		CHECK((last != nullptr) && (strcmp(last->getId(), updated->getId()) == 0));
+	}
+}
+
+static void testJsonNestingLimit() {
+	for (int depth = STACK_MAX_DEPTH - 1; depth <= STACK_MAX_DEPTH + 5; depth++) {
+		std::string document;
+		for (int i = 0; i < depth; i++) {
+			document += (i % 2 ? "[" : "{\"a\":");
+		}
+		document += "1";
+		for (int i = depth - 1; i >= 0; i--) {
+			document += (i % 2 ? "]" : "}");
+		}
+		// the key string is open on top of the innermost object
+		bool fits = (depth + ((depth % 2) ? 1 : 0) <= STACK_MAX_DEPTH);
+		for (size_t pieceLength : { document.length(), (size_t) 1 }) {
+			bool done;
+			parseEvents(document.c_str(), document.length(), pieceLength, &done);
+			char what[48];
+			snprintf(what, sizeof(what), "depth %d in pieces of %zu", depth, pieceLength);
+			check(done == fits, what, __FILE__, __LINE__);
+		}
+	}
+	// too deep fails for good, the rest of the document doesn't end it
+	WJsonParser parser;
+	RecordingListener listener;
+	parser.begin(&listener);
+	std::string deep(STACK_MAX_DEPTH + 1, '[');
+	parser.feed(deep.c_str(), deep.length());
+	CHECK(parser.isFailed());
+	std::string closing(STACK_MAX_DEPTH + 1, ']');
+	parser.feed(closing.c_str(), closing.length());
+	CHECK(parser.isFailed());
+	CHECK(!parser.isDone());
+	CHECK(listener.events.find("end") == std::string::npos);
+	// after the end, the rest is ignored
+	const char* trailing = "{\"a\":1}}]";
+	parser.begin((WJsonListener*) nullptr);
+	parser.feed(trailing, strlen(trailing));
+	CHECK(parser.isDone());
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		testFilter = argv[1];
+	}
+	test("cbor/round-trip", testCborRoundTrip);
+	test("format-double/boundaries", testFormatDoubleBoundaries);
+	test("format-double/sweep", testFormatDoubleSweep);
+	test("format-double/multiple-of", testDecimalsOfMultipleOf);
+	test("json-parser/split", testJsonSplitAtEveryOffset);
+	test("json-parser/nesting", testJsonNestingLimit);
+	printf("%d failed\n", testsFailed);
+	return testsFailed;
+}
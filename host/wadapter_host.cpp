@@ -0,0 +1,103 @@
+/*
+ * Runs WNetwork natively on the host: the web interface and the WebThings
+ * API are served on --http-port, MQTT connects to a real broker if
+ * --mqtt is given. Settings persist in the EEPROM image file
+ * (WADAPTER_EEPROM, default wadapter-eeprom.bin).
+ *
+ *   wadapter_host [--http-port 8080] [--mqtt host[:port]] [--topic name] [--cbor] [--delta] [--single-values] [--debug]
+ */
+
+#include <Arduino.h>
+#include "WNetwork.h"
+#include "WNetworkDevice.h"
+#include "WHostThermostat.h"
+
+const char* HOST_APPLICATION PROGMEM = "WAdapterHost";
+const char* HOST_VERSION PROGMEM = "1.15-fas";
+const byte FLAG_SETTINGS = 0x01;
+
+WNetwork* network;
+
+int main(int argc, char** argv) {
+	hostInit(argc, argv);
+	bool debug = false;
+	String mqttServer = "";
+	String mqttPort = "1883";
+	String mqttTopic = "";
+	bool cbor = false;
+	bool delta = false;
+	bool singleValues = false;
+	httpPort = 8080;
+	for (int i = 1; i < argc; i++) {
+		String arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if ((arg == "--http-port") && (hasValue)) {
+			httpPort = atoi(argv[++i]);
+		} else if ((arg == "--mqtt") && (hasValue)) {
+			mqttServer = argv[++i];
+			int colon = mqttServer.indexOf(':');
+			if (colon >= 0) {
+				mqttPort = mqttServer.substring(colon + 1);
+				mqttServer = mqttServer.substring(0, colon);
+			}
+			if (mqttPort.length() > 4) {
+				// the settings store the port in 4 characters
+				fprintf(stderr, "MQTT port %s is not supported\n", mqttPort.c_str());
+				return 1;
+			}
+		} else if ((arg == "--topic") && (hasValue)) {
+			mqttTopic = argv[++i];
+		} else if (arg == "--cbor") {
+			cbor = true;
+		} else if (arg == "--delta") {
+			delta = true;
+		} else if (arg == "--single-values") {
+			singleValues = true;
+		} else if (arg == "--debug") {
+			debug = true;
+		} else {
+			fprintf(stderr, "usage: %s [--http-port port] [--mqtt host[:port]] [--topic name] [--cbor] [--delta] [--single-values] [--debug]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	network = new WNetwork(debug, HOST_APPLICATION, HOST_VERSION, NO_LED, FLAG_SETTINGS);
+
+	// There's no configuration portal on the host: write the network settings
+	// from the command line and restart, like the device does after /saveConfig.
+	WSettings* settings = network->getSettings();
+	byte netBits = (mqttServer.length() ? NETBITS1_MQTT : 0) | (cbor ? NETBITS1_MQTTCBOR : 0) | (delta ? NETBITS1_MQTTDELTA : 0)
+			| (singleValues ? NETBITS1_MQTTSINGLEVALUES : 0);
+	if ((strlen(settings->getString(PROP_IDX)) == 0)
+			|| (strcmp(settings->getString(PROP_SSID), "host") != 0)
+			|| (strcmp(settings->getString(PROP_MQTTSERVER), mqttServer.c_str()) != 0)
+			|| (strcmp(settings->getString(PROP_MQTTPORT), mqttPort.c_str()) != 0)
+			|| ((mqttTopic.length()) && (strcmp(settings->getString(PROP_MQTTTOPIC), mqttTopic.c_str()) != 0))
+			|| (settings->getByte(PROP_NETBITS1) != netBits)) {
+		if (strlen(settings->getString(PROP_IDX)) == 0) {
+			settings->setString(PROP_IDX, "wadapterhost");
+		}
+		settings->setString(PROP_SSID, "host");
+		settings->setString(PROP_MQTTSERVER, mqttServer.c_str());
+		settings->setString(PROP_MQTTPORT, mqttPort.c_str());
+		if (mqttTopic.length()) {
+			settings->setString(PROP_MQTTTOPIC, mqttTopic.c_str());
+		}
+		settings->setByte(PROP_NETBITS1, netBits);
+		settings->save();
+		ESP.restart();
+	}
+
+	network->addDevice(new WHostThermostat(network));
+	network->addDevice(new WNetworkDev(network, HOST_APPLICATION));
+	network->startWebServer();
+	initStatic();
+	Serial.printf("WAdapter host: http://localhost:%u/things\n", httpPort);
+
+	while (true) {
+		network->loop(millis());
+		webServer->handleClient();
+		delay(10);
+	}
+	return 0;
+}